@@ -1,14 +1,17 @@
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <iostream>
 #include <mutex>
 #include <vector>
 #include <chrono>
+#include "shardedCounter.hpp"
 
 // Global counters
 long long g_counter1 = 0;
 long long g_counter2 = 0;
 std::atomic<long long> atom_counter = 0;
+ShardedCounter sharded_counter;
 constexpr long long N = 1000000000;
 
 // Function to join threads
@@ -52,6 +55,13 @@ int main(){
             atom_counter.fetch_add(1, std::memory_order_relaxed);
         }
     };
+
+    // With sharded counter - correct result, every thread increments its own cache line
+    auto f_sharded_race = [](){
+        for(int i = 0; i < N; i++){
+            sharded_counter.add(1);
+        }
+    };
     
     
     std::vector<std::thread> threads;
@@ -104,6 +114,60 @@ int main(){
     std::cout << "Result counter after atomic relaxed race = " << atom_counter << std::endl;
     duration_ms = end - start;
     std::cout << "Taken time by race: " << duration_ms.count() << " ms\n";
+    threads.clear();
+
+    // Prepare threads for experiment with sharded counter
+    for(int i = 0; i < 4; i++){
+        threads.push_back(std::thread(f_sharded_race));
+    }
+    start = std::chrono::high_resolution_clock::now();
+    joinThreads(threads);
+    end = std::chrono::high_resolution_clock::now();
+    std::cout << "Result counter after sharded race = " << sharded_counter.read() << std::endl;
+    duration_ms = end - start;
+    std::cout << "Taken time by race: " << duration_ms.count() << " ms\n";
+    threads.clear();
+
+    // Scaling: the same number of increments per thread, more threads
+    // A shared atomic gets slower per increment as threads are added, the sharded counter does not
+    constexpr long long M = N / 100;
+    // Start n threads running f, return the time they take to finish in seconds
+    auto timeThreads = [&threads](unsigned n, auto f){
+        for(unsigned i = 0; i < n; i++){
+            threads.push_back(std::thread(f));
+        }
+        auto t0 = std::chrono::high_resolution_clock::now();
+        joinThreads(threads);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        threads.clear();
+        return std::chrono::duration<double>(t1 - t0).count();
+    };
+    auto f_atomic = [](){
+        for(long long i = 0; i < M; i++){
+            atom_counter.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    auto f_sharded = [](){
+        for(long long i = 0; i < M; i++){
+            sharded_counter.add(1);
+        }
+    };
+    // Approximate reads: the slot is updated every 1024 increments
+    auto f_sharded_batched = [](){
+        ShardedCounter::Batch batch(sharded_counter, 1024);
+        for(long long i = 0; i < M; i++){
+            batch.add(1);
+        }
+    };
+    std::cout << "threads | atomic relaxed Mops/s | sharded Mops/s | sharded batched Mops/s\n";
+    unsigned maxThreads = std::max(4u, 2 * std::thread::hardware_concurrency());
+    for(unsigned n = 1; n <= maxThreads; n *= 2){
+        double ops = static_cast<double>(n) * static_cast<double>(M) / 1e6;
+        double atomicSec = timeThreads(n, f_atomic);
+        double shardedSec = timeThreads(n, f_sharded);
+        double batchedSec = timeThreads(n, f_sharded_batched);
+        std::cout << n << " | " << ops / atomicSec << " | " << ops / shardedSec << " | " << ops / batchedSec << std::endl;
+    }
 
     // Final output:
     /*
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "perfCounters.hpp"
+#include "shardedCounter.hpp"
+
+// Atomic read-modify-write matrix: operation x memory order x layout x threads
+// Operations (every thread runs iterations of one of them on "its" atomic):
+// - fetch_add  fetch_add(1, order)
+// - cas        load, then compare_exchange_weak(v, v + 1, order) until it succeeds
+// - exchange   exchange(i, order)
+// - loadstore  load(acquire side of order), store(v + 1, release side of order): two plain
+//              accesses instead of one RMW, loses increments when shared
+// Layouts:
+// - shared        every thread uses the same atomic
+// - padded        one atomic per thread, each on its own cache line
+// - false_shared  one atomic per thread, all on one cache line (threads beyond 8 share again)
+// Per cell: Mops/s over all threads and, per operation, hardware counters summed over the threads
+// (cycles, instructions, cache misses, L1d misses and an optional raw event such as a HITM counter).
+// Without perf_event_open the counters print as -1 and only time stamp counter ticks are left.
+//
+// Usage: atomicMatrix [--ops fetch_add,cas,exchange,loadstore] [--orders relaxed,acquire,release,acq_rel,seq_cst]
+//                     [--layouts shared,padded,false_shared] [--threads 1,2,4] [--iters 10000000]
+//                     [--raw 0xEVENT] [--format table|csv]
+// --raw takes a PERF_TYPE_RAW config, e.g. 0x4d2 (MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM on Skylake)
+
+enum class Op{
+    FetchAdd,
+    Cas,
+    Exchange,
+    LoadStore
+};
+
+enum class Layout{
+    Shared,
+    Padded,
+    FalseShared
+};
+
+using Word = std::atomic<std::uint64_t>;
+using Kernel = void (*)(Word&, std::uint64_t);
+
+// Load and store orders that make up order for a load/store pair
+constexpr std::memory_order loadOrder(std::memory_order order){
+    if(order == std::memory_order_acquire || order == std::memory_order_acq_rel){
+        return std::memory_order_acquire;
+    }
+    return order == std::memory_order_seq_cst ? std::memory_order_seq_cst : std::memory_order_relaxed;
+}
+constexpr std::memory_order storeOrder(std::memory_order order){
+    if(order == std::memory_order_release || order == std::memory_order_acq_rel){
+        return std::memory_order_release;
+    }
+    return order == std::memory_order_seq_cst ? std::memory_order_seq_cst : std::memory_order_relaxed;
+}
+
+template<Op op, std::memory_order order>
+void kernel(Word& w, std::uint64_t iters){
+    for(std::uint64_t i = 0; i < iters; i++){
+        if constexpr(op == Op::FetchAdd){
+            w.fetch_add(1, order);
+        }
+        else if constexpr(op == Op::Cas){
+            auto v = w.load(std::memory_order_relaxed);
+            while(!w.compare_exchange_weak(v, v + 1, order, std::memory_order_relaxed)){
+            }
+        }
+        else if constexpr(op == Op::Exchange){
+            w.exchange(i, order);
+        }
+        else{
+            auto v = w.load(loadOrder(order));
+            w.store(v + 1, storeOrder(order));
+        }
+    }
+}
+
+template<Op op>
+Kernel kernelFor(std::memory_order order){
+    switch(order){
+        case std::memory_order_relaxed:
+            return kernel<op, std::memory_order_relaxed>;
+        case std::memory_order_acquire:
+            return kernel<op, std::memory_order_acquire>;
+        case std::memory_order_release:
+            return kernel<op, std::memory_order_release>;
+        case std::memory_order_acq_rel:
+            return kernel<op, std::memory_order_acq_rel>;
+        default:
+            return kernel<op, std::memory_order_seq_cst>;
+    }
+}
+
+Kernel kernelFor(Op op, std::memory_order order){
+    switch(op){
+        case Op::FetchAdd:
+            return kernelFor<Op::FetchAdd>(order);
+        case Op::Cas:
+            return kernelFor<Op::Cas>(order);
+        case Op::Exchange:
+            return kernelFor<Op::Exchange>(order);
+        default:
+            return kernelFor<Op::LoadStore>(order);
+    }
+}
+
+struct Config{
+    std::vector<std::string> ops{"fetch_add", "cas", "exchange", "loadstore"};
+    std::vector<std::string> orders{"relaxed", "acq_rel", "seq_cst"};
+    std::vector<std::string> layouts{"shared", "padded", "false_shared"};
+    std::vector<std::size_t> threads{1, 2, 4};
+    std::uint64_t iters = 10000000;
+    std::uint64_t raw = 0;
+    std::string format = "table";
+};
+
+struct Cell{
+    double mops = 0;
+    // Per operation, summed over the threads
+    PerfCounters::Values perOp;
+    double tscPerOp = 0;
+};
+
+// Atomics for every layout; a thread picks its word with word(layout, thread)
+class Words{
+    public:
+    explicit Words(std::size_t threads) : padded_(std::make_unique<Padded[]>(threads)){}
+
+    Word& word(Layout layout, std::size_t thread){
+        switch(layout){
+            case Layout::Shared:
+                return shared_.word;
+            case Layout::Padded:
+                return padded_[thread].word;
+            default:
+                return packed_.words[thread % 8];
+        }
+    }
+
+    private:
+    struct alignas(cacheLineSize) Padded{
+        Word word{0};
+    };
+    struct alignas(cacheLineSize) Packed{
+        Word words[8] = {};
+    };
+
+    Padded shared_;
+    std::unique_ptr<Padded[]> padded_;
+    Packed packed_;
+};
+
+Cell run(Kernel k, Layout layout, std::size_t threadCount, const Config& cfg){
+    Words words(threadCount);
+    std::vector<PerfCounters::Values> values(threadCount);
+    std::vector<std::chrono::steady_clock::time_point> starts(threadCount), ends(threadCount);
+    // Workers and this thread: every thread has opened its counters before anybody starts
+    std::barrier sync(static_cast<std::ptrdiff_t>(threadCount) + 1);
+    std::vector<std::thread> pool;
+    for(std::size_t t = 0; t < threadCount; t++){
+        pool.emplace_back([&, t]{
+            PerfCounters counters(cfg.raw);
+            auto& w = words.word(layout, t);
+            sync.arrive_and_wait();
+            starts[t] = std::chrono::steady_clock::now();
+            counters.start();
+            k(w, cfg.iters);
+            values[t] = counters.stop();
+            ends[t] = std::chrono::steady_clock::now();
+        });
+    }
+    sync.arrive_and_wait();
+    for(auto& t : pool){
+        t.join();
+    }
+    // From the first thread starting to the last one finishing
+    auto start = *std::min_element(starts.begin(), starts.end());
+    auto end = *std::max_element(ends.begin(), ends.end());
+
+    double ops = static_cast<double>(cfg.iters) * static_cast<double>(threadCount);
+    Cell c;
+    c.mops = ops / std::chrono::duration<double, std::micro>(end - start).count();
+    for(std::size_t e = 0; e < PerfCounters::EventCount; e++){
+        double sum = 0;
+        for(auto& v : values){
+            if(v.counts[e] < 0){
+                sum = -1;
+                break;
+            }
+            sum += v.counts[e];
+        }
+        c.perOp.counts[e] = sum < 0 ? -1 : sum / ops;
+    }
+    double tsc = 0;
+    for(auto& v : values){
+        tsc += static_cast<double>(v.tsc);
+    }
+    c.tscPerOp = tsc / ops;
+    return c;
+}
+
+std::vector<std::string> split(const std::string& s){
+    std::vector<std::string> parts;
+    std::istringstream in(s);
+    std::string part;
+    while(std::getline(in, part, ',')){
+        if(!part.empty()){
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+Config parse(int argc, char* argv[]){
+    Config cfg;
+    for(int i = 1; i + 1 < argc; i += 2){
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if(key == "--ops"){
+            cfg.ops = split(value);
+        }
+        else if(key == "--orders"){
+            cfg.orders = split(value);
+        }
+        else if(key == "--layouts"){
+            cfg.layouts = split(value);
+        }
+        else if(key == "--threads"){
+            cfg.threads.clear();
+            for(auto& p : split(value)){
+                cfg.threads.push_back(std::max<std::size_t>(1, std::stoul(p)));
+            }
+        }
+        else if(key == "--iters"){
+            cfg.iters = std::stoull(value);
+        }
+        else if(key == "--raw"){
+            cfg.raw = std::stoull(value, nullptr, 0);
+        }
+        else if(key == "--format"){
+            cfg.format = value;
+        }
+        else{
+            std::cerr << "Unknown option " << key << "\n";
+        }
+    }
+    return cfg;
+}
+
+int main(int argc, char* argv[]){
+    auto cfg = parse(argc, argv);
+    const std::pair<const char*, Op> ops[]{
+        {"fetch_add", Op::FetchAdd}, {"cas", Op::Cas}, {"exchange", Op::Exchange}, {"loadstore", Op::LoadStore}};
+    const std::pair<const char*, std::memory_order> orders[]{
+        {"relaxed", std::memory_order_relaxed}, {"acquire", std::memory_order_acquire},
+        {"release", std::memory_order_release}, {"acq_rel", std::memory_order_acq_rel},
+        {"seq_cst", std::memory_order_seq_cst}};
+    const std::pair<const char*, Layout> layouts[]{
+        {"shared", Layout::Shared}, {"padded", Layout::Padded}, {"false_shared", Layout::FalseShared}};
+    auto selected = [](const std::vector<std::string>& list, const char* name){
+        return std::find(list.begin(), list.end(), name) != list.end();
+    };
+
+    {
+        PerfCounters probe(cfg.raw);
+        if(!probe.available()){
+            std::cerr << "perf_event_open unavailable, hardware counters print as -1 (time stamp counter only)\n";
+        }
+    }
+    bool csv = cfg.format == "csv";
+    if(csv){
+        std::cout << "op,order,layout,threads,iters,mops";
+        for(auto name : PerfCounters::names){
+            std::cout << "," << name << "_per_op";
+        }
+        std::cout << ",tsc_per_op\n";
+    }
+    else{
+        std::cout << cfg.iters << " iterations per thread, counters per operation\n"
+                  << "op | order | layout | threads | Mops/s | cycles | instructions | cache-misses | L1d-misses | raw | tsc\n";
+    }
+    for(auto& [opName, op] : ops){
+        if(!selected(cfg.ops, opName)){
+            continue;
+        }
+        for(auto& [orderName, order] : orders){
+            if(!selected(cfg.orders, orderName)){
+                continue;
+            }
+            auto k = kernelFor(op, order);
+            for(auto& [layoutName, layout] : layouts){
+                if(!selected(cfg.layouts, layoutName)){
+                    continue;
+                }
+                for(auto threads : cfg.threads){
+                    auto c = run(k, layout, threads, cfg);
+                    const char* sep = csv ? "," : " | ";
+                    std::cout << opName << sep << orderName << sep << layoutName << sep << threads;
+                    if(csv){
+                        std::cout << sep << cfg.iters;
+                    }
+                    std::cout << sep << c.mops;
+                    for(auto v : c.perOp.counts){
+                        std::cout << sep << v;
+                    }
+                    std::cout << sep << c.tscPerOp << std::endl;
+                }
+            }
+        }
+    }
+}
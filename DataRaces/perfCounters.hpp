@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Hardware counters of the calling thread, user space only
+// Uses perf_event_open on Linux; every event is opened on its own, so a CPU or VM that lacks
+// one of them still reports the rest. An event that could not be opened reads as -1
+// (no PMU in a VM, perf_event_paranoid > 2, not Linux, ...)
+// The time stamp counter is read as well, so there is always a cycle-like number
+class PerfCounters{
+    public:
+    enum Event{
+        Cycles,
+        Instructions,
+        // Last level cache misses
+        CacheMisses,
+        L1dMisses,
+        // Model-specific raw event, e.g. a HITM (load hit a modified line in another core) counter
+        Raw,
+        EventCount
+    };
+    static constexpr std::array<const char*, EventCount> names{"cycles", "instructions", "cache-misses", "L1d-misses", "raw"};
+
+    struct Values{
+        std::array<double, EventCount> counts{-1, -1, -1, -1, -1};
+        std::uint64_t tsc = 0;
+    };
+
+    // rawConfig: config of a PERF_TYPE_RAW event, 0 to skip it
+    explicit PerfCounters(std::uint64_t rawConfig = 0){
+#if defined(__linux__)
+        open(Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open(Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(CacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        open(L1dMisses, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        if(rawConfig != 0){
+            open(Raw, PERF_TYPE_RAW, rawConfig);
+        }
+#else
+        (void)rawConfig;
+#endif
+    }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters(){
+#if defined(__linux__)
+        for(int fd : fds_){
+            if(fd >= 0){
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    // True if at least one hardware event could be opened
+    bool available() const{
+        for(int fd : fds_){
+            if(fd >= 0){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void start(){
+#if defined(__linux__)
+        for(int fd : fds_){
+            if(fd >= 0){
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+        tsc_ = readTsc();
+    }
+    // Counts since start(), scaled up if the kernel had to multiplex the events
+    Values stop(){
+        Values v;
+        v.tsc = readTsc() - tsc_;
+#if defined(__linux__)
+        for(std::size_t i = 0; i < EventCount; i++){
+            if(fds_[i] < 0){
+                continue;
+            }
+            ::ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+            // value, time enabled, time running
+            std::uint64_t data[3] = {};
+            if(::read(fds_[i], data, sizeof(data)) == static_cast<ssize_t>(sizeof(data)) && data[2] > 0){
+                v.counts[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+            }
+        }
+#endif
+        return v;
+    }
+
+    private:
+#if defined(__linux__)
+    void open(Event e, std::uint32_t type, std::uint64_t config){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // This thread on any CPU
+        fds_[e] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+    static std::uint64_t readTsc(){
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    std::array<int, EventCount> fds_{-1, -1, -1, -1, -1};
+    std::uint64_t tsc_ = 0;
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+
+// Distance that keeps two objects off the same cache line
+// GCC warns that the value depends on -mtune; it only sizes padding here, never an interface
+#ifdef __cpp_lib_hardware_interference_size
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline constexpr std::size_t cacheLineSize = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+inline constexpr std::size_t cacheLineSize = 64;
+#endif
+
+// Counter split into slots, each on its own cache line
+// - every thread is given one slot (round robin, at least one per core, rounded up to a power of two)
+//   and only adds to it, so increments from different threads never touch the same line:
+//   a relaxed RMW on a line the core already owns instead of a line that moves on every increment
+// - read() sums the slots: exact once the writers are done; while they run (and only add)
+//   it lies between the values at the start and at the end of the call
+// - Batch counts in a plain variable and adds to the slot every flushEvery increments,
+//   read() then lags behind by at most flushEvery - 1 per live Batch
+class ShardedCounter{
+    public:
+    // Increments buffered by one thread; flushes the rest when destroyed
+    class Batch{
+        public:
+        Batch(ShardedCounter& counter, long long flushEvery) : counter_(counter), flushEvery_(std::max(flushEvery, 1ll)){}
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+        ~Batch(){
+            flush();
+        }
+
+        void add(long long n = 1){
+            pending_ += n;
+            if(pending_ >= flushEvery_ || pending_ <= -flushEvery_){
+                flush();
+            }
+        }
+        void flush(){
+            if(pending_ != 0){
+                counter_.add(pending_);
+                pending_ = 0;
+            }
+        }
+
+        private:
+        ShardedCounter& counter_;
+        long long flushEvery_;
+        long long pending_ = 0;
+    };
+
+    explicit ShardedCounter(std::size_t slots = std::max(1u, std::thread::hardware_concurrency()))
+        : count_(std::bit_ceil(std::max<std::size_t>(slots, 1))), slots_(std::make_unique<Slot[]>(count_)){}
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void add(long long n = 1){
+        slots_[threadSlot() & (count_ - 1)].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    ShardedCounter& operator++(){
+        add(1);
+        return *this;
+    }
+
+    long long read() const{
+        long long sum = 0;
+        for(std::size_t i = 0; i < count_; i++){
+            sum += slots_[i].value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+    // Not atomic with respect to concurrent add()
+    void reset(){
+        for(std::size_t i = 0; i < count_; i++){
+            slots_[i].value.store(0, std::memory_order_relaxed);
+        }
+    }
+    std::size_t slots() const{
+        return count_;
+    }
+
+    private:
+    struct alignas(cacheLineSize) Slot{
+        std::atomic<long long> value{0};
+    };
+
+    // Slot number of the calling thread, the same for every ShardedCounter
+    static std::size_t threadSlot(){
+        static std::atomic<std::size_t> nextSlot{0};
+        thread_local std::size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    std::size_t count_;
+    std::unique_ptr<Slot[]> slots_;
+};
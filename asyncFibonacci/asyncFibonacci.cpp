@@ -9,6 +9,10 @@
 #include <future>
 #include <ostream>
 #include <thread>
+#include "brLock.hpp"
+#include "concurrentHashMap.hpp"
+#include "concurrentMemo.hpp"
+#include "snapshot.hpp"
 
 constexpr int MAX_N = 93;
 
@@ -88,15 +92,16 @@ void initCacheNotAtomic(auto& cache){
 }
 
 // Thread-safe Fibonacci function using shared_mutex
-int fibonacciThred(int n, std::shared_mutex& mut, auto& memo){
+// (or any other SharedMutex, e.g. BrLock)
+int fibonacciThred(int n, auto& mut, auto& memo){
     {
         std::shared_lock lk(mut);
         if(memo.contains(n)){
             return memo[n];
         }
     }
-    auto a = fibonacciThred(n - 1, std::ref(mut), memo);
-    auto b = fibonacciThred(n - 2, std::ref(mut), memo);
+    auto a = fibonacciThred(n - 1, mut, memo);
+    auto b = fibonacciThred(n - 2, mut, memo);
     auto sum = a + b;
     {
         std::unique_lock lk(mut);
@@ -128,6 +133,51 @@ int fibonacciSharedPtrAtomic(int n, auto& cachePtr){
     return sum;
 }
 
+// Thread-safe Fibonacci function using a lock-free hash map
+// Lookups only load, a new value is one CAS; nothing is copied as the cache grows
+int fibonacciConcurrentMap(int n, auto& memo){
+    if(auto val = memo.find(n)){
+        return *val;
+    }
+    auto a = fibonacciConcurrentMap(n - 1, memo);
+    auto b = fibonacciConcurrentMap(n - 2, memo);
+    auto sum = a + b;
+    memo.insert(n, sum);
+    return sum;
+}
+
+// Thread-safe Fibonacci function using an RCU-style Snapshot of the map
+// Readers pin an epoch instead of touching a shared reference count,
+// a writer copies the map and publishes the copy with one CAS (retrying instead of losing the insert)
+int fibonacciSnapshot(int n, auto& cache){
+    {
+        auto snapshot = cache.read();
+        if(snapshot->contains(n)){
+            return snapshot->at(n);
+        }
+    }
+    auto a = fibonacciSnapshot(n - 1, cache);
+    auto b = fibonacciSnapshot(n - 2, cache);
+    auto sum = a + b;
+    cache.update([&](auto& map){
+        map.try_emplace(n, sum);
+    });
+    return sum;
+}
+
+// Fibonacci step for ConcurrentMemo: the memo calls it once per n,
+// threads asking for an n being computed wait for that result instead of recursing too
+auto fibonacciStep = [](const int& n, auto& memo) -> int{
+    if(n <= 1){
+        return n;
+    }
+    return memo.get(n - 1) + memo.get(n - 2);
+};
+
+int fibonacciMemo(int n, auto& memo){
+    return memo.get(n);
+}
+
 int main(){
     {
         std::unordered_map<int, int> memo;
@@ -208,15 +258,32 @@ int main(){
         memo[1] = 1;
         auto f1 = 0, f2 = 0, f3 = 0;
         std::shared_mutex mut;
-        std::thread t1([&]{f1 = fibonacciThred(40, std::ref(mut), memo);});
-        std::thread t2([&]{f1 = fibonacciThred(41, std::ref(mut), memo);}); 
-        std::thread t3([&]{f1 = fibonacciThred(42, std::ref(mut), memo);});
+        std::thread t1([&]{f1 = fibonacciThred(40, mut, memo);});
+        std::thread t2([&]{f1 = fibonacciThred(41, mut, memo);}); 
+        std::thread t3([&]{f1 = fibonacciThred(42, mut, memo);});
         t1.join();
         t2.join();
         t3.join();
         auto end = std::chrono::high_resolution_clock::now();
         std::cout << "Time for thread shared_mutex fibonacci " << end - start << std::endl;
     }
+    {
+        std::unordered_map<int, int> memo;
+        auto start = std::chrono::high_resolution_clock::now();
+        memo[0] = 0;
+        memo[1] = 1;
+        auto f1 = 0, f2 = 0, f3 = 0;
+        // Readers increment a counter on their own cache line instead of a shared one
+        BrLock mut;
+        std::thread t1([&]{f1 = fibonacciThred(40, mut, memo);});
+        std::thread t2([&]{f2 = fibonacciThred(41, mut, memo);});
+        std::thread t3([&]{f3 = fibonacciThred(42, mut, memo);});
+        t1.join();
+        t2.join();
+        t3.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Time for thread BrLock fibonacci " << end - start << std::endl;
+    }
     {
         
         using MapPtr = std::shared_ptr<std::unordered_map<int, int>>;
@@ -236,6 +303,53 @@ int main(){
         auto end = std::chrono::high_resolution_clock::now();
         std::cout << "Time for thread atomic shared_ptr fibonacci " << end - start << std::endl;
     }
+    {
+        auto memo = std::make_unique<std::unordered_map<int, int>>();
+        (*memo)[0] = 0;
+        (*memo)[1] = 1;
+        auto start = std::chrono::high_resolution_clock::now();
+        Snapshot<std::unordered_map<int, int>> cache(std::move(memo));
+        auto f1 = 0, f2 = 0, f3 = 0;
+        std::thread t1([&]{f1 = fibonacciSnapshot(40, cache);});
+        std::thread t2([&]{f2 = fibonacciSnapshot(41, cache);});
+        std::thread t3([&]{f3 = fibonacciSnapshot(42, cache);});
+        t1.join();
+        t2.join();
+        t3.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Time for thread Snapshot fibonacci " << end - start << std::endl;
+    }
+    {
+        ConcurrentHashMap<int, int> memo(64);
+        auto start = std::chrono::high_resolution_clock::now();
+        memo.insert(0, 0);
+        memo.insert(1, 1);
+        auto f1 = 0, f2 = 0, f3 = 0;
+        std::thread t1([&]{f1 = fibonacciConcurrentMap(40, memo);});
+        std::thread t2([&]{f2 = fibonacciConcurrentMap(41, memo);});
+        std::thread t3([&]{f3 = fibonacciConcurrentMap(42, memo);});
+        t1.join();
+        t2.join();
+        t3.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Time for thread concurrent hash map fibonacci " << end - start << std::endl;
+    }
+    {
+        ConcurrentMemo<int, int, decltype(fibonacciStep)> memo(fibonacciStep);
+        auto start = std::chrono::high_resolution_clock::now();
+        auto f1 = 0, f2 = 0, f3 = 0;
+        std::thread t1([&]{f1 = fibonacciMemo(40, memo);});
+        std::thread t2([&]{f2 = fibonacciMemo(41, memo);});
+        std::thread t3([&]{f3 = fibonacciMemo(42, memo);});
+        t1.join();
+        t2.join();
+        t3.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto stats = memo.stats();
+        // 43 values (0..42), each computed once
+        std::cout << "Time for thread ConcurrentMemo fibonacci " << end - start << " (computes " << stats.computes
+                  << ", waits " << stats.waits << ")" << std::endl;
+    }
 }
 
 /*
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "brLock.hpp"
+#include "concurrentHashMap.hpp"
+#include "concurrentMemo.hpp"
+#include "histogram.hpp"
+
+// The asyncFibonacci caches with many keys instead of n <= 42
+// Every thread asks for keys out of [0, keys) and computes a missing value itself (except with ConcurrentMemo);
+// the cache starts empty, so the run moves from mostly inserts to mostly hits
+// Caches:
+// - shared_mutex / BrLock + unordered_map (fibonacciThred)
+// - atomic<shared_ptr> to an unordered_map copied on every insert (fibonacciSharedPtrAtomic),
+//   only up to cowMaxKeys keys: a copy per insert is quadratic in the key count
+// - ConcurrentHashMap (fibonacciConcurrentMap)
+// - ConcurrentMemo (fibonacciMemo): concurrent misses of one key wait for a single computation
+// Besides throughput: computations made, duplicates (computations beyond one per distinct key)
+// and lookup latency percentiles
+// Two workloads: random keys with a cheap function, and a stampede where every thread misses
+// the same keys at the same time and a computation is expensive
+//
+// Usage: cacheBench [keys] [max threads] [lookups per thread]
+
+constexpr std::size_t cowMaxKeys = 1 << 14;
+
+// Rounds of mixing per computation
+std::size_t computeRounds = 32;
+// Computations made by this thread
+thread_local std::uint64_t computeCalls = 0;
+
+// The memoized function
+std::uint64_t compute(std::uint64_t key){
+    computeCalls++;
+    std::uint64_t x = key;
+    for(std::size_t i = 0; i < computeRounds; i++){
+        x ^= x >> 31;
+        x *= 0x9e3779b97f4a7c15ULL;
+    }
+    return x;
+}
+
+template<typename Mutex>
+class LockedCache{
+    public:
+    std::uint64_t get(std::uint64_t key){
+        {
+            std::shared_lock lk(mut_);
+            auto it = map_.find(key);
+            if(it != map_.end()){
+                return it->second;
+            }
+        }
+        auto val = compute(key);
+        std::unique_lock lk(mut_);
+        return map_.try_emplace(key, val).first->second;
+    }
+
+    private:
+    Mutex mut_;
+    std::unordered_map<std::uint64_t, std::uint64_t> map_;
+};
+
+class CowCache{
+    public:
+    using Map = std::unordered_map<std::uint64_t, std::uint64_t>;
+
+    std::uint64_t get(std::uint64_t key){
+        auto snapshot = ptr_.load(std::memory_order_acquire);
+        auto it = snapshot->find(key);
+        if(it != snapshot->end()){
+            return it->second;
+        }
+        auto val = compute(key);
+        auto newMap = std::make_shared<Map>(*snapshot);
+        (*newMap)[key] = val;
+        // Like fibonacciSharedPtrAtomic: one attempt, a lost race loses the insert
+        ptr_.compare_exchange_strong(snapshot, newMap, std::memory_order_release, std::memory_order_relaxed);
+        return val;
+    }
+
+    private:
+    std::atomic<std::shared_ptr<Map>> ptr_{std::make_shared<Map>()};
+};
+
+class HashMapCache{
+    public:
+    std::uint64_t get(std::uint64_t key){
+        if(auto val = map_.find(key)){
+            return *val;
+        }
+        auto val = compute(key);
+        map_.insert(key, val);
+        return val;
+    }
+
+    private:
+    ConcurrentHashMap<std::uint64_t, std::uint64_t> map_{1024};
+};
+
+class MemoCache{
+    public:
+    std::uint64_t get(std::uint64_t key){
+        return memo_.get(key);
+    }
+
+    private:
+    ConcurrentMemo<std::uint64_t, std::uint64_t, std::uint64_t (*)(std::uint64_t)> memo_{compute};
+};
+
+struct Workload{
+    std::size_t keys;
+    std::size_t lookups;
+    // Every thread asks for 0, 1, 2, ... in the same order instead of random keys
+    bool stampede;
+};
+
+struct Result{
+    double mops = 0;
+    std::uint64_t computes = 0;
+    std::chrono::nanoseconds p50{}, p99{}, max{};
+};
+
+// Key number i of thread t
+std::uint64_t keyOf(const Workload& w, std::uint64_t& rng, std::size_t i){
+    if(w.stampede){
+        return i % w.keys;
+    }
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng % w.keys;
+}
+std::uint64_t seedOf(std::size_t thread){
+    return 0x2545f4914f6cdd1dULL * (thread + 1);
+}
+
+// Keys asked for at least once: the number of computations a perfect cache makes
+std::size_t distinctKeys(const Workload& w, std::size_t threads){
+    std::vector<bool> seen(w.keys);
+    std::size_t n = 0;
+    for(std::size_t t = 0; t < threads; t++){
+        auto rng = seedOf(t);
+        for(std::size_t i = 0; i < w.lookups; i++){
+            auto k = keyOf(w, rng, i);
+            n += !seen[k];
+            seen[k] = true;
+        }
+    }
+    return n;
+}
+
+// Lookups per second over all threads and computations, on a fresh cache
+// Every 16th lookup is timed
+template<typename Cache>
+Result run(std::size_t threads, const Workload& w){
+    Cache cache;
+    std::barrier sync(static_cast<std::ptrdiff_t>(threads) + 1);
+    std::atomic<std::uint64_t> sink{0}, computes{0};
+    std::vector<LatencyHistogram> latency(threads);
+    std::vector<std::thread> pool;
+    for(std::size_t t = 0; t < threads; t++){
+        pool.emplace_back([&, t]{
+            auto rng = seedOf(t);
+            std::uint64_t sum = 0;
+            computeCalls = 0;
+            sync.arrive_and_wait();
+            for(std::size_t i = 0; i < w.lookups; i++){
+                auto key = keyOf(w, rng, i);
+                if(i % 16 == 0){
+                    auto before = std::chrono::steady_clock::now();
+                    sum += cache.get(key);
+                    latency[t].record(std::chrono::steady_clock::now() - before);
+                }
+                else{
+                    sum += cache.get(key);
+                }
+            }
+            sink.fetch_add(sum, std::memory_order_relaxed);
+            computes.fetch_add(computeCalls, std::memory_order_relaxed);
+        });
+    }
+    sync.arrive_and_wait();
+    auto start = std::chrono::steady_clock::now();
+    for(auto& t : pool){
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    LatencyHistogram all;
+    for(auto& h : latency){
+        all.merge(h);
+    }
+    Result r;
+    r.mops = static_cast<double>(threads * w.lookups) / std::chrono::duration<double, std::micro>(end - start).count();
+    r.computes = computes.load();
+    r.p50 = all.percentile(0.5);
+    r.p99 = all.percentile(0.99);
+    r.max = all.max();
+    return r;
+}
+
+template<typename Cache>
+void row(const char* name, std::size_t threads, const Workload& w, std::size_t distinct){
+    auto r = run<Cache>(threads, w);
+    std::cout << threads << " | " << name << " | " << r.mops << " | " << r.computes << " | " << r.computes - distinct
+              << " | " << r.p50.count() << " | " << r.p99.count() << " | " << r.max.count() << std::endl;
+}
+
+void table(const Workload& w, std::size_t maxThreads){
+    std::cout << "threads | cache | Mops/s | computes | duplicates | p50 ns | p99 ns | max ns\n";
+    for(std::size_t threads = 1; threads <= maxThreads; threads *= 2){
+        auto distinct = distinctKeys(w, threads);
+        row<LockedCache<std::shared_mutex>>("shared_mutex", threads, w, distinct);
+        row<LockedCache<BrLock>>("BrLock", threads, w, distinct);
+        if(w.keys <= cowMaxKeys){
+            row<CowCache>("atomic shared_ptr", threads, w, distinct);
+        }
+        row<HashMapCache>("ConcurrentHashMap", threads, w, distinct);
+        row<MemoCache>("ConcurrentMemo", threads, w, distinct);
+    }
+}
+
+int main(int argc, char* argv[]){
+    std::size_t keys = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+    std::size_t maxThreads = argc > 2 ? std::stoul(argv[2]) : 8;
+    std::size_t lookups = argc > 3 ? std::stoul(argv[3]) : 1 << 20;
+    keys = std::max<std::size_t>(keys, 1);
+
+    std::cout << "Random keys: " << keys << " keys, " << lookups << " lookups per thread\n";
+    table({keys, lookups, false}, maxThreads);
+
+    // Every thread misses the same keys at the same time, a computation costs microseconds
+    computeRounds = 4096;
+    std::cout << "Stampede: 1024 keys asked for in the same order by every thread, " << computeRounds
+              << " rounds per computation\n";
+    table({1024, 4096, true}, maxThreads);
+}
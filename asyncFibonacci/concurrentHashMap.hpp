@@ -0,0 +1,257 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+// Insert-only concurrent hash map for memo caches: a key's value never changes once inserted
+// - open addressing with linear probing; a slot is a key, a value and a state word
+// - find() only loads: no locks, no shared writes, no retries
+// - insert() claims a slot with one CAS on its key, writes the value and publishes it with a CAS on the state
+// - growing never stops the world: a full table gets a twice larger successor, every insert
+//   first copies one chunk of slots into it, and finds look in the successor for keys they do not see
+// Lifetime of old tables: a reader may still be probing one, so they are freed with the map
+// (all of them together are smaller than the last one)
+// Key and Value must be trivially copyable with lock-free atomics (integers, pointers, small structs);
+// one key value (emptyKey, by default the largest one) marks free slots and cannot be inserted
+template<typename Key, typename Value>
+class ConcurrentHashMap{
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>);
+    static_assert(std::atomic<Key>::is_always_lock_free && std::atomic<Value>::is_always_lock_free);
+
+    public:
+    explicit ConcurrentHashMap(std::size_t capacity = 1024, Key emptyKey = std::numeric_limits<Key>::max())
+        : emptyKey_(emptyKey){
+        auto first = new Table(std::bit_ceil(std::max<std::size_t>(capacity, minCapacity)), emptyKey_);
+        first_ = first;
+        root_.store(first, std::memory_order_relaxed);
+    }
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+    ~ConcurrentHashMap(){
+        for(Table* t = first_; t != nullptr;){
+            Table* next = t->next.load(std::memory_order_relaxed);
+            delete t;
+            t = next;
+        }
+    }
+
+    std::optional<Value> find(Key key) const{
+        auto h = hash(key);
+        for(Table* t = root_.load(std::memory_order_acquire); t != nullptr; t = t->next.load(std::memory_order_acquire)){
+            auto mask = t->capacity - 1;
+            for(std::size_t i = 0; i < maxProbe; i++){
+                auto& slot = t->slots[(h + i) & mask];
+                Key k = slot.key.load(std::memory_order_acquire);
+                if(k == emptyKey_){
+                    break;
+                }
+                if(k == key){
+                    if(slot.state.load(std::memory_order_acquire) == Ready){
+                        return slot.value.load(std::memory_order_relaxed);
+                    }
+                    // Being inserted or dropped by a move: a successor may have it
+                    break;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Insert if absent; false if the key is already there (or being inserted by another thread)
+    // Throws std::invalid_argument for emptyKey
+    bool insert(Key key, Value value){
+        if(key == emptyKey_){
+            throw std::invalid_argument("ConcurrentHashMap: the empty key cannot be inserted");
+        }
+        return insertFrom(root_.load(std::memory_order_acquire), key, value);
+    }
+
+    // Slots in the newest table
+    std::size_t capacity() const{
+        Table* t = root_.load(std::memory_order_acquire);
+        while(Table* next = t->next.load(std::memory_order_acquire)){
+            t = next;
+        }
+        return t->capacity;
+    }
+
+    private:
+    // Slot states
+    static constexpr std::uint8_t Empty = 0;
+    static constexpr std::uint8_t Ready = 1;
+    // Closed by a move to the successor: a value not published by then goes to the successor
+    static constexpr std::uint8_t Moved = 2;
+
+    static constexpr std::size_t minCapacity = 64;
+    // An insert needing more probes grows the table; finds never look further
+    static constexpr std::size_t maxProbe = 32;
+    // Slots copied to the successor per insert
+    static constexpr std::size_t moveChunk = 256;
+
+    struct Slot{
+        std::atomic<Key> key;
+        std::atomic<Value> value{};
+        std::atomic<std::uint8_t> state{Empty};
+    };
+
+    struct Table{
+        Table(std::size_t cap, Key emptyKey) : capacity(cap), slots(new Slot[cap]){
+            for(std::size_t i = 0; i < cap; i++){
+                slots[i].key.store(emptyKey, std::memory_order_relaxed);
+            }
+        }
+        ~Table(){
+            delete[] slots;
+        }
+
+        std::size_t capacity;
+        Slot* slots;
+        std::atomic<Table*> next{nullptr};
+        // Moving: next chunk to claim and slots done
+        alignas(64) std::atomic<std::size_t> moveCursor{0};
+        std::atomic<std::size_t> moved{0};
+    };
+
+    bool insertFrom(Table* t, Key key, Value value){
+        auto h = hash(key);
+        while(true){
+            Table* next = t->next.load(std::memory_order_seq_cst);
+            if(next != nullptr){
+                helpMove(t, next);
+            }
+            auto mask = t->capacity - 1;
+            // No free slot within maxProbe
+            bool full = true;
+            for(std::size_t i = 0; i < maxProbe; i++){
+                auto& slot = t->slots[(h + i) & mask];
+                // seq_cst, pairs with the claim below
+                Key k = slot.key.load(std::memory_order_seq_cst);
+                if(k == emptyKey_){
+                    if(next != nullptr || slot.state.load(std::memory_order_acquire) == Moved){
+                        // Not here: new keys go to the successor
+                        full = false;
+                        break;
+                    }
+                    // seq_cst: a thread that has seen the successor and then probes for this key
+                    // either sees the claim, or this thread sees the successor below
+                    if(!slot.key.compare_exchange_strong(k, key, std::memory_order_seq_cst, std::memory_order_acquire)){
+                        if(k != key){
+                            // Lost the slot to another key, probe on
+                            continue;
+                        }
+                        return false;
+                    }
+                    slot.value.store(value, std::memory_order_relaxed);
+                    std::uint8_t expected = Empty;
+                    if(t->next.load(std::memory_order_seq_cst) == nullptr &&
+                       slot.state.compare_exchange_strong(expected, Ready, std::memory_order_release, std::memory_order_relaxed)){
+                        return true;
+                    }
+                    // A successor appeared: give the slot up (unless a move closed it already)
+                    // and insert there, so a key is published in one table only
+                    expected = Empty;
+                    slot.state.compare_exchange_strong(expected, Moved, std::memory_order_relaxed);
+                    full = false;
+                    break;
+                }
+                if(k == key){
+                    if(slot.state.load(std::memory_order_acquire) != Moved){
+                        return false;
+                    }
+                    // Dropped by a move before it was published, the successor decides
+                    full = false;
+                    break;
+                }
+            }
+            if(next == nullptr){
+                if(full){
+                    grow(t);
+                }
+                // Probe this table once more: a key claimed here meanwhile is found, not inserted twice
+                continue;
+            }
+            t = next;
+        }
+    }
+
+    // Install a successor twice the size of t, unless another thread has
+    void grow(Table* t){
+        if(t->next.load(std::memory_order_acquire) != nullptr){
+            return;
+        }
+        auto fresh = new Table(t->capacity * 2, emptyKey_);
+        Table* expected = nullptr;
+        if(!t->next.compare_exchange_strong(expected, fresh, std::memory_order_seq_cst, std::memory_order_relaxed)){
+            delete fresh;
+        }
+    }
+
+    // Copy one chunk of t into its successor; the last chunk makes the successor the root
+    void helpMove(Table* t, Table* next){
+        auto begin = t->moveCursor.fetch_add(moveChunk, std::memory_order_relaxed);
+        if(begin >= t->capacity){
+            return;
+        }
+        auto end = std::min(begin + moveChunk, t->capacity);
+        for(auto i = begin; i < end; i++){
+            auto& slot = t->slots[i];
+            std::uint8_t state = Empty;
+            // Close free and unpublished slots; their inserts go to the successor
+            if(slot.state.compare_exchange_strong(state, Moved, std::memory_order_acq_rel, std::memory_order_acquire)){
+                continue;
+            }
+            if(state == Ready){
+                insertFrom(next, slot.key.load(std::memory_order_relaxed), slot.value.load(std::memory_order_relaxed));
+            }
+        }
+        if(t->moved.fetch_add(end - begin, std::memory_order_acq_rel) + (end - begin) == t->capacity){
+            promote();
+        }
+    }
+
+    // Advance the root past every table that is moved completely
+    void promote(){
+        Table* r = root_.load(std::memory_order_acquire);
+        while(Table* next = r->next.load(std::memory_order_acquire)){
+            if(r->moved.load(std::memory_order_acquire) != r->capacity){
+                return;
+            }
+            if(root_.compare_exchange_strong(r, next, std::memory_order_acq_rel, std::memory_order_acquire)){
+                r = next;
+            }
+        }
+    }
+
+    // splitmix64 finalizer over the key bytes
+    static std::size_t hash(Key key){
+        std::uint64_t x = 0;
+        if constexpr(std::is_integral_v<Key>){
+            x = static_cast<std::uint64_t>(key);
+        }
+        else if constexpr(std::is_pointer_v<Key>){
+            x = reinterpret_cast<std::uintptr_t>(key);
+        }
+        else{
+            static_assert(sizeof(Key) <= sizeof(x));
+            std::memcpy(&x, &key, sizeof(Key));
+        }
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return static_cast<std::size_t>(x);
+    }
+
+    Key emptyKey_;
+    Table* first_;
+    // Oldest table still being read from; successors hang off next
+    alignas(64) std::atomic<Table*> root_;
+};
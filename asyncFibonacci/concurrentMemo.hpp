@@ -0,0 +1,175 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// Memoizer that computes every key once, however many threads ask for it at the same time
+// - the first caller of a missing key inserts an in-flight entry (a shared_future) and computes
+//   outside the lock; callers arriving meanwhile wait on that future instead of computing again,
+//   later callers find the value itself in the entry
+// - if f throws, every waiter gets the exception and the entry is dropped, so the next call retries
+// - the keys are split over shards with a mutex each, so threads asking for different keys rarely meet
+// - with a capacity the least recently used entries are evicted (per shard); an evicted key is
+//   computed again when it is asked for, waiters already holding its future still get the value
+// f is called as f(key), or as f(key, memo) so it can ask the memo for other keys (recursion);
+// such dependencies must not form a cycle, a thread would wait for itself
+template<typename Key, typename Value, typename F, typename Hash = std::hash<Key>>
+class ConcurrentMemo{
+    public:
+    struct Stats{
+        // Calls of f
+        std::uint64_t computes = 0;
+        // Found a value
+        std::uint64_t hits = 0;
+        // Found an in-flight entry and waited for it instead of computing
+        std::uint64_t waits = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    // capacity 0: unbounded
+    explicit ConcurrentMemo(F f, std::size_t capacity = 0, std::size_t shards = 16)
+        : f_(std::move(f)), shardCount_(std::max<std::size_t>(shards, 1)),
+          shardCapacity_(capacity == 0 ? 0 : std::max<std::size_t>(1, (capacity + shardCount_ - 1) / shardCount_)),
+          shards_(std::make_unique<Shard[]>(shardCount_)){}
+    ConcurrentMemo(const ConcurrentMemo&) = delete;
+    ConcurrentMemo& operator=(const ConcurrentMemo&) = delete;
+
+    Value get(const Key& key){
+        auto& shard = shards_[Hash{}(key) % shardCount_];
+        std::optional<std::promise<Value>> promise;
+        std::shared_future<Value> future;
+        std::uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lk(shard.mut);
+            auto it = shard.map.find(key);
+            if(it != shard.map.end()){
+                if(shardCapacity_ != 0){
+                    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+                }
+                if(it->second.value){
+                    shard.stats.hits++;
+                    return *it->second.value;
+                }
+                shard.stats.waits++;
+                future = it->second.pending;
+            }
+            else{
+                promise.emplace();
+                future = promise->get_future().share();
+                generation = ++shard.generation;
+                typename std::list<Key>::iterator pos;
+                if(shardCapacity_ != 0){
+                    shard.lru.push_front(key);
+                    pos = shard.lru.begin();
+                }
+                shard.map.emplace(key, Entry{std::nullopt, future, pos, generation});
+                shard.stats.computes++;
+                evict(shard);
+            }
+        }
+        if(generation == 0){
+            // Somebody else computes it; get() rethrows their exception
+            return future.get();
+        }
+        try{
+            if constexpr(std::is_invocable_v<F&, const Key&, ConcurrentMemo&>){
+                promise->set_value(f_(key, *this));
+            }
+            else{
+                promise->set_value(f_(key));
+            }
+        }
+        catch(...){
+            promise->set_exception(std::current_exception());
+            drop(shard, key, generation);
+            return future.get();
+        }
+        publish(shard, key, generation, future.get());
+        return future.get();
+    }
+
+    Stats stats() const{
+        Stats total;
+        for(std::size_t i = 0; i < shardCount_; i++){
+            std::lock_guard<std::mutex> lk(shards_[i].mut);
+            total.computes += shards_[i].stats.computes;
+            total.hits += shards_[i].stats.hits;
+            total.waits += shards_[i].stats.waits;
+            total.evictions += shards_[i].stats.evictions;
+        }
+        return total;
+    }
+    // Entries, in-flight ones included
+    std::size_t size() const{
+        std::size_t n = 0;
+        for(std::size_t i = 0; i < shardCount_; i++){
+            std::lock_guard<std::mutex> lk(shards_[i].mut);
+            n += shards_[i].map.size();
+        }
+        return n;
+    }
+
+    private:
+    struct Entry{
+        // Set once computed: hits copy it under the shard lock without touching the future
+        std::optional<Value> value;
+        // For the threads that arrive while it is computed
+        std::shared_future<Value> pending;
+        // Position in the LRU list (bounded memo only)
+        typename std::list<Key>::iterator lru;
+        // Tells a failed computation's entry apart from a newer one for the same key
+        std::uint64_t generation;
+    };
+    struct alignas(64) Shard{
+        mutable std::mutex mut;
+        std::unordered_map<Key, Entry, Hash> map;
+        // Most recently used first
+        std::list<Key> lru;
+        std::uint64_t generation = 0;
+        Stats stats;
+    };
+
+    // Drop least recently used entries until the shard fits (mut held)
+    void evict(Shard& shard){
+        while(shardCapacity_ != 0 && shard.map.size() > shardCapacity_){
+            shard.map.erase(shard.lru.back());
+            shard.lru.pop_back();
+            shard.stats.evictions++;
+        }
+    }
+    // Store a computed value in its entry, unless the entry was evicted meanwhile
+    void publish(Shard& shard, const Key& key, std::uint64_t generation, const Value& value){
+        std::lock_guard<std::mutex> lk(shard.mut);
+        auto it = shard.map.find(key);
+        if(it != shard.map.end() && it->second.generation == generation){
+            it->second.value = value;
+            it->second.pending = {};
+        }
+    }
+    // Remove the entry of a failed computation, unless it was replaced meanwhile
+    void drop(Shard& shard, const Key& key, std::uint64_t generation){
+        std::lock_guard<std::mutex> lk(shard.mut);
+        auto it = shard.map.find(key);
+        if(it != shard.map.end() && it->second.generation == generation){
+            if(shardCapacity_ != 0){
+                shard.lru.erase(it->second.lru);
+            }
+            shard.map.erase(it);
+        }
+    }
+
+    F f_;
+    std::size_t shardCount_;
+    std::size_t shardCapacity_;
+    std::unique_ptr<Shard[]> shards_;
+};
@@ -0,0 +1,235 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Epoch-based reclamation shared by every Snapshot
+// - a thread takes a slot (its own cache line) the first time it reads and gives it back when it exits
+// - pin() writes the current epoch into the own slot, unpin() writes 0: readers never write shared memory
+// - a writer that replaced a version advances the epoch and frees the old version once every
+//   pinned slot shows a later epoch: those readers started after the replacement and cannot hold it
+class EpochDomain{
+    public:
+    static constexpr std::size_t maxThreads = 512;
+
+    static EpochDomain& instance(){
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // Pins nest: only the outermost pin / unpin touch the slot
+    void pin(){
+        auto& self = threadState();
+        if(self.depth++ == 0){
+            if(self.slot == noSlot){
+                self.slot = claimSlot();
+            }
+            // seq_cst store: ordered before the reader's load of the version (store-load),
+            // so a writer that scans after replacing it either sees this pin or this reader sees the new version
+            slots_[self.slot].announce.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+    }
+    void unpin(){
+        auto& self = threadState();
+        if(--self.depth == 0){
+            slots_[self.slot].announce.store(0, std::memory_order_release);
+        }
+    }
+
+    // Epoch a version retired now is tagged with (call after unpublishing it)
+    std::uint64_t advance(){
+        return epoch_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    // Versions retired at an epoch below this are free of readers
+    std::uint64_t oldestPinned() const{
+        std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+        // seq_cst: a slot claimed after this load belongs to a reader that will see the new version
+        auto used = used_.load(std::memory_order_seq_cst);
+        for(std::size_t i = 0; i < used; i++){
+            auto e = slots_[i].announce.load(std::memory_order_seq_cst);
+            if(e != 0){
+                oldest = std::min(oldest, e);
+            }
+        }
+        return oldest;
+    }
+
+    private:
+    static constexpr std::size_t noSlot = std::numeric_limits<std::size_t>::max();
+
+    struct alignas(64) Slot{
+        // Epoch when the thread pinned, 0 when not reading
+        std::atomic<std::uint64_t> announce{0};
+        std::atomic<bool> taken{false};
+    };
+    struct ThreadState{
+        std::size_t slot = noSlot;
+        unsigned depth = 0;
+        ~ThreadState(){
+            if(slot != noSlot){
+                instance().slots_[slot].taken.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    static ThreadState& threadState(){
+        thread_local ThreadState state;
+        return state;
+    }
+    // First free slot; the scanned range only grows
+    std::size_t claimSlot(){
+        for(std::size_t i = 0; i < maxThreads; i++){
+            bool expected = false;
+            if(!slots_[i].taken.load(std::memory_order_relaxed) &&
+               slots_[i].taken.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+                auto used = used_.load(std::memory_order_relaxed);
+                while(used < i + 1 && !used_.compare_exchange_weak(used, i + 1, std::memory_order_seq_cst)){
+                }
+                return i;
+            }
+        }
+        throw std::runtime_error("EpochDomain: more than maxThreads threads are reading");
+    }
+
+    alignas(64) std::atomic<std::uint64_t> epoch_{1};
+    std::atomic<std::size_t> used_{0};
+    Slot slots_[maxThreads];
+};
+
+// RCU-style versioned value: readers see an immutable T, writers replace it as a whole
+// - read() pins the epoch and loads the current version: no lock, no reference count,
+//   no write to memory another thread writes; the guard keeps the version alive
+// - a writer publishes a new version with one CAS (compare_and_publish / update) or an exchange (publish)
+// - replaced versions are freed by writers, once no reader pinned before the replacement is left
+// Readers may stay pinned only briefly: a long pin holds back every version retired meanwhile
+template<typename T>
+class Snapshot{
+    public:
+    class ReadGuard{
+        public:
+        ReadGuard(ReadGuard&& other) noexcept
+            : ptr_(std::exchange(other.ptr_, nullptr)), pinned_(std::exchange(other.pinned_, false)){}
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ReadGuard(const ReadGuard&) = delete;
+        ~ReadGuard(){
+            if(pinned_){
+                EpochDomain::instance().unpin();
+            }
+        }
+
+        const T* get() const{
+            return ptr_;
+        }
+        const T& operator*() const{
+            return *ptr_;
+        }
+        const T* operator->() const{
+            return ptr_;
+        }
+
+        private:
+        friend class Snapshot;
+        explicit ReadGuard(const std::atomic<T*>& current){
+            EpochDomain::instance().pin();
+            ptr_ = current.load(std::memory_order_seq_cst);
+        }
+
+        const T* ptr_;
+        // Tracked apart from ptr_: a null version is pinned as well
+        bool pinned_ = true;
+    };
+
+    explicit Snapshot(std::unique_ptr<T> initial) : current_(initial.release()){}
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+    // No reader may be left
+    ~Snapshot(){
+        delete current_.load(std::memory_order_relaxed);
+        for(auto& r : retired_){
+            delete r.ptr;
+        }
+    }
+
+    ReadGuard read() const{
+        return ReadGuard(current_);
+    }
+
+    // Replace expected (from a ReadGuard) by desired with one CAS; on failure desired is left untouched
+    // (expected itself is freed only after the caller's guard is gone, at a later retirement)
+    bool compare_and_publish(const T* expected, std::unique_ptr<T>& desired){
+        if(!replace(expected, desired)){
+            return false;
+        }
+        retire(const_cast<T*>(expected));
+        return true;
+    }
+    void publish(std::unique_ptr<T> desired){
+        retire(current_.exchange(desired.release(), std::memory_order_seq_cst));
+    }
+    // Copy the current version, let f modify the copy and publish it; retries if another writer was first
+    template<typename F>
+    void update(F&& f){
+        while(true){
+            const T* old = nullptr;
+            bool replaced = false;
+            {
+                auto guard = read();
+                auto copy = std::make_unique<T>(*guard);
+                f(*copy);
+                old = guard.get();
+                replaced = replace(old, copy);
+            }
+            // Unpinned, so the old version can go as soon as other readers leave it
+            if(replaced){
+                retire(const_cast<T*>(old));
+                return;
+            }
+        }
+    }
+
+    // Retired versions not freed yet
+    std::size_t pending() const{
+        std::lock_guard<std::mutex> lk(retiredMtx_);
+        return retired_.size();
+    }
+
+    private:
+    struct Retired{
+        T* ptr;
+        std::uint64_t epoch;
+    };
+
+    bool replace(const T* expected, std::unique_ptr<T>& desired){
+        T* old = const_cast<T*>(expected);
+        if(!current_.compare_exchange_strong(old, desired.get(), std::memory_order_seq_cst, std::memory_order_relaxed)){
+            return false;
+        }
+        desired.release();
+        return true;
+    }
+    void retire(T* old){
+        auto& domain = EpochDomain::instance();
+        auto epoch = domain.advance();
+        std::lock_guard<std::mutex> lk(retiredMtx_);
+        retired_.push_back({old, epoch});
+        auto oldest = domain.oldestPinned();
+        auto keep = std::partition(retired_.begin(), retired_.end(), [oldest](const Retired& r){
+            return r.epoch >= oldest;
+        });
+        for(auto it = keep; it != retired_.end(); ++it){
+            delete it->ptr;
+        }
+        retired_.erase(keep, retired_.end());
+    }
+
+    alignas(64) std::atomic<T*> current_;
+    mutable std::mutex retiredMtx_;
+    std::vector<Retired> retired_;
+};
@@ -0,0 +1,149 @@
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "snapshot.hpp"
+
+// Read-side scaling of three ways to share a value that is replaced now and then
+// - Snapshot<T>: epoch pin in a private slot + pointer load
+// - std::atomic<std::shared_ptr<const T>>: libstdc++ guards it with a lock bit and every load
+//   changes the shared reference count
+// - std::shared_mutex around a T: every reader writes the lock word
+// Reader threads copy one word out of the current version for a fixed time, one writer thread
+// publishes a new version every period; readers check that a version is never torn
+//
+// Usage: snapshotBench [max readers] [ms per run] [writer period us]
+
+struct Data{
+    // Every word holds the version number
+    std::array<std::uint64_t, 8> words{};
+};
+
+std::unique_ptr<Data> makeVersion(std::uint64_t version){
+    auto d = std::make_unique<Data>();
+    d->words.fill(version);
+    return d;
+}
+
+class SnapshotShare{
+    public:
+    template<typename F>
+    void read(F&& f){
+        auto guard = snap_.read();
+        f(*guard);
+    }
+    void write(std::uint64_t version){
+        snap_.publish(makeVersion(version));
+    }
+
+    private:
+    Snapshot<Data> snap_{makeVersion(0)};
+};
+
+class AtomicSharedPtrShare{
+    public:
+    template<typename F>
+    void read(F&& f){
+        auto p = ptr_.load(std::memory_order_acquire);
+        f(*p);
+    }
+    void write(std::uint64_t version){
+        ptr_.store(std::shared_ptr<const Data>(makeVersion(version)), std::memory_order_release);
+    }
+
+    private:
+    std::atomic<std::shared_ptr<const Data>> ptr_{std::shared_ptr<const Data>(makeVersion(0))};
+};
+
+class SharedMutexShare{
+    public:
+    template<typename F>
+    void read(F&& f){
+        std::shared_lock lk(mut_);
+        f(data_);
+    }
+    void write(std::uint64_t version){
+        std::unique_lock lk(mut_);
+        data_.words.fill(version);
+    }
+
+    private:
+    std::shared_mutex mut_;
+    Data data_;
+};
+
+struct Result{
+    double readsPerSec = 0;
+    std::uint64_t writes = 0;
+    std::uint64_t torn = 0;
+};
+
+template<typename Share>
+Result run(std::size_t readers, std::chrono::milliseconds duration, std::chrono::microseconds period){
+    Share share;
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> reads{0}, torn{0}, writes{0};
+    // Readers, the writer and this thread
+    std::barrier sync(static_cast<std::ptrdiff_t>(readers) + 2);
+    std::vector<std::thread> pool;
+    for(std::size_t t = 0; t < readers; t++){
+        pool.emplace_back([&, t]{
+            std::uint64_t n = 0, bad = 0;
+            sync.arrive_and_wait();
+            while(!stop.load(std::memory_order_relaxed)){
+                share.read([&](const Data& d){
+                    bad += d.words[t % 8] != d.words[(t + 1) % 8];
+                });
+                n++;
+            }
+            reads.fetch_add(n, std::memory_order_relaxed);
+            torn.fetch_add(bad, std::memory_order_relaxed);
+        });
+    }
+    pool.emplace_back([&]{
+        std::uint64_t version = 0;
+        sync.arrive_and_wait();
+        auto next = std::chrono::steady_clock::now();
+        while(!stop.load(std::memory_order_relaxed)){
+            share.write(++version);
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+        writes.store(version, std::memory_order_relaxed);
+    });
+    sync.arrive_and_wait();
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for(auto& t : pool){
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return {static_cast<double>(reads.load()) / std::chrono::duration<double>(end - start).count(), writes.load(),
+            torn.load()};
+}
+
+int main(int argc, char* argv[]){
+    std::size_t maxReaders = argc > 1 ? std::stoul(argv[1]) : 64;
+    std::chrono::milliseconds duration(argc > 2 ? std::stoul(argv[2]) : 200);
+    std::chrono::microseconds period(argc > 3 ? std::stoul(argv[3]) : 1000);
+
+    std::cout << "One writer every " << period.count() << " us, " << duration.count() << " ms per run\n"
+              << "readers | Snapshot Mreads/s | atomic shared_ptr Mreads/s | shared_mutex Mreads/s | torn reads\n";
+    for(std::size_t readers = 1; readers <= maxReaders; readers *= 2){
+        auto s = run<SnapshotShare>(readers, duration, period);
+        auto a = run<AtomicSharedPtrShare>(readers, duration, period);
+        auto m = run<SharedMutexShare>(readers, duration, period);
+        std::cout << readers << " | " << s.readsPerSec / 1e6 << " | " << a.readsPerSec / 1e6 << " | "
+                  << m.readsPerSec / 1e6 << " | " << s.torn + a.torn + m.torn << std::endl;
+    }
+}
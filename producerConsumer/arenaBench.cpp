@@ -0,0 +1,144 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "messageArena.hpp"
+#include "mpmcQueue.hpp"
+
+// Message payloads: heap strings vs MessageArena
+// Both versions send "<thread id> <i>" through an MpmcQueue, producers x consumers threads
+// Every operator new is counted to show heap allocations per message
+// Usage: arenaBench [messages per producer] [capacity]
+
+std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size == 0 ? 1 : size)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+using Clock = std::chrono::steady_clock;
+
+std::string threadName(){
+    std::ostringstream ss;
+    ss << std::this_thread::get_id();
+    return ss.str();
+}
+
+struct Result{
+    double mops;
+    double allocsPerMessage;
+};
+
+// Producer builds a payload and pushes it, consumer reads it: returns throughput and allocations
+template<typename T, typename Make, typename Read>
+Result run(std::size_t producers, std::size_t consumers, std::size_t messages, std::size_t capacity,
+           Make make, Read read){
+    MpmcQueue<T> queue(capacity);
+    std::atomic<std::size_t> bytes{0};
+    std::atomic<std::size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::size_t before = 0;
+    Clock::time_point start;
+    {
+        std::vector<std::jthread> con;
+        for(std::size_t c = 0; c < consumers; c++){
+            con.emplace_back([&]{
+                T item;
+                std::size_t sum = 0;
+                while(queue.pop(item)){
+                    sum += read(item);
+                }
+                bytes += sum;
+            });
+        }
+        {
+            std::vector<std::jthread> prod;
+            for(std::size_t p = 0; p < producers; p++){
+                prod.emplace_back([&, p]{
+                    auto name = threadName();
+                    ready++;
+                    while(!go.load(std::memory_order_acquire)){
+                        std::this_thread::yield();
+                    }
+                    for(std::size_t i = 0; i < messages; i++){
+                        queue.push(make(p, name, i));
+                    }
+                });
+            }
+            // Thread start-up allocations are not counted
+            while(ready.load() != producers){
+                std::this_thread::yield();
+            }
+            before = allocations.load();
+            start = Clock::now();
+            go.store(true, std::memory_order_release);
+        }
+        queue.close();
+    }
+    std::chrono::duration<double> sec = Clock::now() - start;
+    auto total = static_cast<double>(producers * messages);
+    if(bytes.load() == 0){
+        std::cout << "Nothing read!\n";
+    }
+    return Result{total / sec.count() / 1e6, static_cast<double>(allocations.load() - before) / total};
+}
+
+int main(int argc, char* argv[]){
+    std::size_t messages = 500'000, capacity = 1024;
+    if(argc > 1){
+        messages = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        capacity = std::stoul(argv[2]);
+    }
+    std::cout << messages << " messages per producer, queue capacity " << capacity << "\n"
+              << "producers x consumers | version | Mops/s | allocations/message\n";
+    for(auto [producers, consumers] : {std::pair<std::size_t, std::size_t>{1, 1}, {2, 2}, {4, 4}}){
+        auto strings = run<std::string>(producers, consumers, messages, capacity,
+            [](std::size_t, const std::string& name, std::size_t i){
+                return name + " " + std::to_string(i);
+            },
+            [](const std::string& s){
+                return s.size();
+            });
+        std::cout << producers << "x" << consumers << " | std::string | " << strings.mops << " | "
+                  << strings.allocsPerMessage << std::endl;
+
+        std::vector<std::unique_ptr<MessageArena>> arenas;
+        for(std::size_t p = 0; p < producers; p++){
+            arenas.push_back(std::make_unique<MessageArena>());
+        }
+        auto arena = run<MessageArena::Message>(producers, consumers, messages, capacity,
+            [&](std::size_t p, const std::string& name, std::size_t i){
+                return arenas[p]->compose(name, ' ', i);
+            },
+            [](MessageArena::Message& m){
+                auto n = m.view().size();
+                m.release();
+                return n;
+            });
+        std::size_t slabs = 0;
+        for(auto& a : arenas){
+            slabs += a->stats().slabsAllocated;
+        }
+        std::cout << producers << "x" << consumers << " | MessageArena | " << arena.mops << " | "
+                  << arena.allocsPerMessage << " (" << slabs << " slabs)" << std::endl;
+    }
+}
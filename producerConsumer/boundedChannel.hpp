@@ -0,0 +1,221 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+// What push does when the channel is full
+// Block      - wait for a free place (the only policy where push may sleep)
+// DropNewest - discard the item being pushed
+// DropOldest - discard the oldest queued item to make room
+// Overwrite  - replace the newest queued item (keeps only the latest value at the end of the queue)
+enum class FullPolicy{
+    Block,
+    DropNewest,
+    DropOldest,
+    Overwrite
+};
+
+// Bounded multi-producer multi-consumer channel on a deque guarded by one mutex
+// - push_n / pop_n move a batch under one lock and wake the other side once
+// - the other side is notified only if somebody waits, so a busy channel makes no futex calls
+// - close() wakes every waiter at once: pop drains the rest and then fails, push fails
+template<typename T>
+class BoundedChannel{
+    public:
+    // Counters since construction
+    struct Stats{
+        std::uint64_t pushed = 0;
+        std::uint64_t popped = 0;
+        std::uint64_t dropped = 0;
+        // Returns from a condition variable wait
+        std::uint64_t consumerWakeups = 0;
+        std::uint64_t producerWakeups = 0;
+    };
+
+    explicit BoundedChannel(std::size_t capacity, FullPolicy policy = FullPolicy::Block)
+        : capacity_(std::max<std::size_t>(capacity, 1)), policy_(policy){}
+    BoundedChannel(const BoundedChannel&) = delete;
+    BoundedChannel& operator=(const BoundedChannel&) = delete;
+
+    // Returns false if the channel is closed or the item was dropped
+    template<typename U>
+    bool push(U&& item){
+        std::unique_lock<std::mutex> lk(mtx_);
+        if(!waitForSpace(lk)){
+            return false;
+        }
+        bool stored = place(std::forward<U>(item));
+        auto waiting = consumersWaiting_;
+        lk.unlock();
+        wake(notEmpty_, waiting, stored ? 1 : 0);
+        return stored;
+    }
+
+    // Push n items starting at first under one lock (with Block: as many locks as the channel fills up)
+    // Returns the number of items stored (dropped items and items refused after close() are not counted)
+    template<typename It>
+    std::size_t push_n(It first, std::size_t n){
+        std::size_t stored = 0;
+        std::size_t done = 0;
+        while(done < n){
+            std::unique_lock<std::mutex> lk(mtx_);
+            if(!waitForSpace(lk)){
+                break;
+            }
+            // Block stores what fits and waits again, the other policies take everything now
+            auto k = policy_ == FullPolicy::Block ? std::min(n - done, capacity_ - deq_.size()) : n - done;
+            std::size_t s = 0;
+            for(std::size_t i = 0; i < k; i++, ++first){
+                s += place(std::move(*first));
+            }
+            done += k;
+            stored += s;
+            auto waiting = consumersWaiting_;
+            lk.unlock();
+            wake(notEmpty_, waiting, s);
+        }
+        return stored;
+    }
+
+    // Sleep while empty; returns false if the channel is closed and drained
+    bool pop(T& item){
+        std::unique_lock<std::mutex> lk(mtx_);
+        if(!waitForItems(lk)){
+            return false;
+        }
+        item = std::move(deq_.front());
+        deq_.pop_front();
+        stats_.popped++;
+        auto waiting = producersWaiting_;
+        lk.unlock();
+        wake(notFull_, waiting, 1);
+        return true;
+    }
+
+    // Sleep while empty, then move up to max items to out under one lock
+    // Returns 0 only if the channel is closed and drained
+    template<typename OutIt>
+    std::size_t pop_n(OutIt out, std::size_t max){
+        std::unique_lock<std::mutex> lk(mtx_);
+        if(max == 0 || !waitForItems(lk)){
+            return 0;
+        }
+        auto n = std::min(max, deq_.size());
+        std::move(deq_.begin(), deq_.begin() + static_cast<std::ptrdiff_t>(n), out);
+        deq_.erase(deq_.begin(), deq_.begin() + static_cast<std::ptrdiff_t>(n));
+        stats_.popped += n;
+        auto waiting = producersWaiting_;
+        lk.unlock();
+        wake(notFull_, waiting, n);
+        return n;
+    }
+
+    void close(){
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    bool closed() const{
+        std::lock_guard<std::mutex> lk(mtx_);
+        return closed_;
+    }
+    std::size_t size() const{
+        std::lock_guard<std::mutex> lk(mtx_);
+        return deq_.size();
+    }
+    std::size_t capacity() const{
+        return capacity_;
+    }
+    FullPolicy policy() const{
+        return policy_;
+    }
+    Stats stats() const{
+        std::lock_guard<std::mutex> lk(mtx_);
+        return stats_;
+    }
+
+    private:
+    // With Block wait until there is room; false if the channel is closed
+    bool waitForSpace(std::unique_lock<std::mutex>& lk){
+        if(policy_ == FullPolicy::Block){
+            while(deq_.size() >= capacity_ && !closed_){
+                producersWaiting_++;
+                notFull_.wait(lk);
+                producersWaiting_--;
+                stats_.producerWakeups++;
+            }
+        }
+        return !closed_;
+    }
+    // Wait until there is an item or the channel is closed; false if closed and empty
+    bool waitForItems(std::unique_lock<std::mutex>& lk){
+        while(deq_.empty() && !closed_){
+            consumersWaiting_++;
+            notEmpty_.wait(lk);
+            consumersWaiting_--;
+            stats_.consumerWakeups++;
+        }
+        return !deq_.empty();
+    }
+    // Put the item applying the full-queue policy (mtx_ held, room guaranteed for Block)
+    // Returns false if the item was dropped
+    template<typename U>
+    bool place(U&& item){
+        if(deq_.size() >= capacity_){
+            switch(policy_){
+                case FullPolicy::Block:
+                    break;
+                case FullPolicy::DropNewest:
+                    stats_.dropped++;
+                    return false;
+                case FullPolicy::DropOldest:
+                    deq_.pop_front();
+                    stats_.dropped++;
+                    break;
+                case FullPolicy::Overwrite:
+                    deq_.back() = std::forward<U>(item);
+                    stats_.dropped++;
+                    stats_.pushed++;
+                    return true;
+            }
+        }
+        deq_.push_back(std::forward<U>(item));
+        stats_.pushed++;
+        return true;
+    }
+    // Wake as many waiters as there are new items / free places, nobody if nobody waits
+    // waiting was read under the lock that published the change: a waiter not counted then
+    // checks the queue under the lock before it sleeps and finds the change itself
+    static void wake(std::condition_variable& cv, std::size_t waiting, std::size_t n){
+        if(waiting == 0 || n == 0){
+            return;
+        }
+        if(n >= waiting){
+            cv.notify_all();
+        }
+        else{
+            for(std::size_t i = 0; i < n; i++){
+                cv.notify_one();
+            }
+        }
+    }
+
+    std::size_t capacity_;
+    FullPolicy policy_;
+    std::deque<T> deq_;
+    mutable std::mutex mtx_;
+    std::condition_variable notEmpty_, notFull_;
+    std::size_t consumersWaiting_ = 0;
+    std::size_t producersWaiting_ = 0;
+    bool closed_ = false;
+    Stats stats_;
+};
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "boundedChannel.hpp"
+#include "mutexQueue.hpp"
+
+// BoundedChannel: batch size sweep and full-queue policies
+// Sweep: producers push items in batches of b (push_n), consumers drain with pop_n(b);
+//        throughput and condition variable wakeups per item are printed for every b
+// Policies: a fast producer and a slow consumer, how many items each policy delivers and drops
+// Usage: channelBench [items] [producers] [consumers] [capacity]
+
+using Clock = std::chrono::steady_clock;
+
+struct SweepResult{
+    double mops;
+    double consumerWakeups;
+    double producerWakeups;
+};
+
+SweepResult sweep(std::size_t batch, std::size_t items, std::size_t producers, std::size_t consumers,
+                  std::size_t capacity){
+    BoundedChannel<std::uint64_t> channel(capacity);
+    std::vector<std::uint64_t> sums(consumers);
+    auto start = Clock::now();
+    {
+        std::vector<std::jthread> con;
+        for(std::size_t c = 0; c < consumers; c++){
+            con.emplace_back([&, c]{
+                std::vector<std::uint64_t> buf(batch);
+                std::uint64_t sum = 0;
+                while(auto n = channel.pop_n(buf.begin(), batch)){
+                    for(std::size_t i = 0; i < n; i++){
+                        sum += buf[i];
+                    }
+                }
+                sums[c] = sum;
+            });
+        }
+        {
+            std::vector<std::jthread> prod;
+            for(std::size_t p = 0; p < producers; p++){
+                prod.emplace_back([&, p]{
+                    std::vector<std::uint64_t> buf;
+                    buf.reserve(batch);
+                    for(std::size_t i = p; i < items; i += producers){
+                        buf.push_back(i);
+                        if(buf.size() == batch){
+                            channel.push_n(buf.begin(), buf.size());
+                            buf.clear();
+                        }
+                    }
+                    channel.push_n(buf.begin(), buf.size());
+                });
+            }
+        }
+        channel.close();
+    }
+    std::chrono::duration<double> sec = Clock::now() - start;
+    std::uint64_t sum = 0;
+    for(auto s : sums){
+        sum += s;
+    }
+    if(sum != static_cast<std::uint64_t>(items) * (items - 1) / 2){
+        std::cout << "Lost items!\n";
+    }
+    auto stats = channel.stats();
+    auto n = static_cast<double>(items);
+    return SweepResult{n / sec.count() / 1e6, static_cast<double>(stats.consumerWakeups) / n,
+                       static_cast<double>(stats.producerWakeups) / n};
+}
+
+// Original scheme: one lock and one notify per item
+double baseline(std::size_t items, std::size_t producers, std::size_t consumers, std::size_t capacity){
+    MutexQueue<std::uint64_t> queue(capacity);
+    auto start = Clock::now();
+    {
+        std::vector<std::jthread> con;
+        for(std::size_t c = 0; c < consumers; c++){
+            con.emplace_back([&]{
+                std::uint64_t item;
+                while(queue.pop(item)){
+                }
+            });
+        }
+        {
+            std::vector<std::jthread> prod;
+            for(std::size_t p = 0; p < producers; p++){
+                prod.emplace_back([&, p]{
+                    for(std::size_t i = p; i < items; i += producers){
+                        queue.push(static_cast<std::uint64_t>(i));
+                    }
+                });
+            }
+        }
+        queue.close();
+    }
+    std::chrono::duration<double> sec = Clock::now() - start;
+    return static_cast<double>(items) / sec.count() / 1e6;
+}
+
+void policy(const std::string& name, FullPolicy p, std::size_t capacity){
+    constexpr std::size_t items = 20'000;
+    BoundedChannel<std::uint64_t> channel(capacity, p);
+    std::size_t delivered = 0;
+    std::uint64_t last = 0;
+    {
+        std::jthread consumer([&]{
+            std::uint64_t item;
+            while(channel.pop(item)){
+                delivered++;
+                last = item;
+                // Slow consumer
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+        });
+        for(std::size_t i = 1; i <= items; i++){
+            channel.push(static_cast<std::uint64_t>(i));
+        }
+        channel.close();
+    }
+    auto stats = channel.stats();
+    std::cout << name << ": delivered " << delivered << ", dropped " << stats.dropped
+              << ", last delivered " << last << " of " << items << std::endl;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t items = 2'000'000, producers = 1, consumers = 1, capacity = 1024;
+    if(argc > 1){
+        items = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        producers = std::stoul(argv[2]);
+    }
+    if(argc > 3){
+        consumers = std::stoul(argv[3]);
+    }
+    if(argc > 4){
+        capacity = std::stoul(argv[4]);
+    }
+    std::cout << items << " items, " << producers << " producers, " << consumers << " consumers, capacity "
+              << capacity << "\n"
+              << "lock per item (MutexQueue): " << baseline(items, producers, consumers, capacity) << " Mops/s\n"
+              << "batch | Mops/s | consumer wakeups/item | producer wakeups/item\n";
+    for(std::size_t batch : {1, 4, 16, 64, 256, 1024}){
+        auto r = sweep(batch, items, producers, consumers, capacity);
+        std::cout << batch << " | " << r.mops << " | " << r.consumerWakeups << " | " << r.producerWakeups << std::endl;
+    }
+
+    std::cout << "Full-queue policies, capacity 64, slow consumer\n";
+    policy("Block     ", FullPolicy::Block, 64);
+    policy("DropNewest", FullPolicy::DropNewest, 64);
+    policy("DropOldest", FullPolicy::DropOldest, 64);
+    policy("Overwrite ", FullPolicy::Overwrite, 64);
+}
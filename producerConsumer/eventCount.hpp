@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Sleep / wake-up helper for non-blocking queues (an "event count")
+// Waiter:   e = prepare(); if(condition) done; announce(); if(condition) done; wait(e);
+// Notifier: make the condition true; notify();
+// announce() and notify() both issue a seq_cst fence, so either the waiter sees the condition
+// in its second check or the notifier sees the raised flag and bumps the epoch the waiter sleeps on
+// The notifier clears the flag, so a burst of operations pays for one wake-up only,
+// a waiter going back to sleep raises the flag again
+class EventCount{
+    public:
+    std::uint32_t prepare() const{
+        return epoch_.load(std::memory_order_acquire);
+    }
+    void announce(){
+        sleepers_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    // Returns at once if notify() happened after prepare() returned seen
+    void wait(std::uint32_t seen) const{
+        epoch_.wait(seen, std::memory_order_acquire);
+    }
+    // Costs one fence and one load when nobody sleeps
+    void notify(){
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(sleepers_.load(std::memory_order_relaxed) && sleepers_.exchange(false, std::memory_order_relaxed)){
+            notifyAll();
+        }
+    }
+    // Wake every waiter unconditionally (e.g. on close)
+    void notifyAll(){
+        epoch_.fetch_add(1, std::memory_order_release);
+        epoch_.notify_all();
+    }
+
+    private:
+    std::atomic<std::uint32_t> epoch_{0};
+    std::atomic<bool> sleepers_{false};
+};
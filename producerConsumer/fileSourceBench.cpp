@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "mappedFile.hpp"
+#include "mpmcQueue.hpp"
+
+// Reading a large line-oriented log: std::getline + std::string vs mmap + line-aligned string_view chunks
+// 1. newline scan of the mapped file on one thread: byte loop, memchr, findNewline (SSE2 / AVX2)
+// 2. getline producer pushing every line as a std::string, consumers count lines and bytes
+// 3. P producers splitting the mapped file by offset, pushing string_view chunks, consumers split them into lines
+// The file is generated on the first run; the getline pass runs first and warms the page cache for both
+// Usage: fileSourceBench [file] [size in MiB] [producers] [consumers] [chunk KiB]
+
+using Clock = std::chrono::steady_clock;
+
+void generate(const std::string& path, std::size_t bytes){
+    std::ofstream out(path, std::ios::binary);
+    std::string buf;
+    buf.reserve(1 << 20);
+    std::size_t written = 0;
+    for(std::uint64_t i = 0; written < bytes; i++){
+        buf += "2026-10-17T12:";
+        buf += std::to_string(10 + i % 50);
+        buf += ":00.";
+        buf += std::to_string(100 + i % 900);
+        buf += i % 17 == 0 ? " WARN " : " INFO ";
+        buf += "worker-" + std::to_string(i % 64) + " request " + std::to_string(i);
+        // Lines of 60 to about 200 bytes
+        buf.append(i * 2654435761u % 140, 'x');
+        buf += " took " + std::to_string(i % 997) + " ms\n";
+        if(buf.size() >= (1 << 20)){
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            written += buf.size();
+            buf.clear();
+        }
+    }
+}
+
+struct Count{
+    std::size_t lines = 0;
+    std::size_t bytes = 0;
+};
+
+void report(const char* name, double sec, std::size_t fileSize, Count c){
+    std::cout << name << ": " << static_cast<double>(fileSize) / sec / 1e9 << " GB/s, " << c.lines << " lines, "
+              << c.bytes << " line bytes" << std::endl;
+}
+
+template<typename Find>
+double scan(std::string_view text, Find find, std::size_t& lines){
+    auto start = Clock::now();
+    lines = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while((p = find(p, end)) != end){
+        lines++;
+        p++;
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Count getlineRun(const std::string& path, std::size_t consumers, double& sec){
+    MpmcQueue<std::string> queue(4096);
+    std::atomic<std::size_t> lines{0}, bytes{0};
+    auto start = Clock::now();
+    {
+        std::vector<std::jthread> con;
+        for(std::size_t c = 0; c < consumers; c++){
+            con.emplace_back([&]{
+                std::string line;
+                std::size_t l = 0, b = 0;
+                while(queue.pop(line)){
+                    l++;
+                    b += line.size();
+                }
+                lines += l;
+                bytes += b;
+            });
+        }
+        std::ifstream in(path);
+        std::string line;
+        while(std::getline(in, line)){
+            queue.push(std::move(line));
+        }
+        queue.close();
+    }
+    sec = std::chrono::duration<double>(Clock::now() - start).count();
+    return Count{lines, bytes};
+}
+
+Count mmapRun(const MappedFile& file, std::size_t producers, std::size_t consumers, std::size_t chunk, double& sec){
+    MpmcQueue<std::string_view> queue(1024);
+    std::atomic<std::size_t> lines{0}, bytes{0};
+    auto start = Clock::now();
+    {
+        std::vector<std::jthread> con;
+        for(std::size_t c = 0; c < consumers; c++){
+            con.emplace_back([&]{
+                std::string_view piece;
+                std::size_t l = 0, b = 0;
+                while(queue.pop(piece)){
+                    l += forEachLine(piece, [&](std::string_view line){
+                        b += line.size();
+                    });
+                }
+                lines += l;
+                bytes += b;
+            });
+        }
+        {
+            std::vector<std::jthread> prod;
+            for(std::size_t p = 0; p < producers; p++){
+                prod.emplace_back([&, p]{
+                    LineChunks chunks(file.text(), chunk, p, producers);
+                    std::string_view piece;
+                    while(chunks.next(piece)){
+                        queue.push(piece);
+                    }
+                });
+            }
+        }
+        queue.close();
+    }
+    sec = std::chrono::duration<double>(Clock::now() - start).count();
+    return Count{lines, bytes};
+}
+
+int main(int argc, char* argv[]){
+    std::string path = (std::filesystem::temp_directory_path() / "fileSourceBench.log").string();
+    std::size_t mib = 2048, producers = 2, consumers = 2, chunkKib = 256;
+    if(argc > 1){
+        path = argv[1];
+    }
+    if(argc > 2){
+        mib = std::stoul(argv[2]);
+    }
+    if(argc > 3){
+        producers = std::stoul(argv[3]);
+    }
+    if(argc > 4){
+        consumers = std::stoul(argv[4]);
+    }
+    if(argc > 5){
+        chunkKib = std::stoul(argv[5]);
+    }
+    std::error_code ec;
+    if(std::filesystem::file_size(path, ec) < mib << 20 || ec){
+        std::cout << "Generating " << mib << " MiB in " << path << std::endl;
+        generate(path, mib << 20);
+    }
+
+    double sec = 0;
+    auto base = getlineRun(path, consumers, sec);
+    MappedFile file(path);
+    std::cout << path << ": " << file.size() / 1e9 << " GB\n";
+    report("getline + std::string, 1 producer", sec, file.size(), base);
+
+    std::size_t lines = 0;
+    auto text = file.text();
+    std::cout << "Newline scan, 1 thread\n";
+    sec = scan(text, [](const char* p, const char* end){
+        while(p != end && *p != '\n'){
+            p++;
+        }
+        return p;
+    }, lines);
+    report("  byte loop  ", sec, file.size(), Count{lines, 0});
+    sec = scan(text, [](const char* p, const char* end){
+        auto nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        return nl == nullptr ? end : nl;
+    }, lines);
+    report("  memchr     ", sec, file.size(), Count{lines, 0});
+    sec = scan(text, findNewline, lines);
+    report("  findNewline", sec, file.size(), Count{lines, 0});
+
+    for(std::size_t p = 1; p <= producers; p *= 2){
+        auto c = mmapRun(file, p, consumers, chunkKib << 10, sec);
+        std::string name = "mmap + string_view chunks, " + std::to_string(p) + " producers";
+        report(name.c_str(), sec, file.size(), c);
+        if(c.lines != base.lines || c.bytes != base.bytes){
+            std::cout << "Line count differs from getline!\n";
+        }
+    }
+}
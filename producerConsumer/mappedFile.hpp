@@ -0,0 +1,180 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Line-oriented input without copies: the file is mapped into memory,
+// producers hand out line-aligned chunks of it as string_views and consumers split them into lines
+
+// Position of the first '\n' in [p, end), end if there is none
+// Compares 32 (AVX2) or 16 (SSE2) bytes at once, the tail byte by byte
+inline const char* findNewline(const char* p, const char* end){
+#if defined(__AVX2__)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for(; end - p >= 32; p += 32){
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, nl)));
+        if(mask != 0){
+            return p + std::countr_zero(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    for(; end - p >= 16; p += 16){
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, nl)));
+        if(mask != 0){
+            return p + std::countr_zero(mask);
+        }
+    }
+#endif
+    for(; p != end; p++){
+        if(*p == '\n'){
+            return p;
+        }
+    }
+    return end;
+}
+
+// Call f(line) for every line of text (without the '\n'), returns the number of lines
+// A last line without a trailing '\n' counts too
+template<typename F>
+std::size_t forEachLine(std::string_view text, F&& f){
+    const char* p = text.data();
+    const char* end = p + text.size();
+    std::size_t lines = 0;
+    while(p != end){
+        const char* nl = findNewline(p, end);
+        f(std::string_view(p, static_cast<std::size_t>(nl - p)));
+        lines++;
+        p = nl == end ? end : nl + 1;
+    }
+    return lines;
+}
+
+// Read-only view of a whole file: mmap on POSIX systems, a heap copy elsewhere
+// Throws std::system_error if the file cannot be opened
+class MappedFile{
+    public:
+    explicit MappedFile(const std::string& path){
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){
+            throw std::system_error(errno, std::generic_category(), "MappedFile: cannot open " + path);
+        }
+        struct stat st{};
+        if(::fstat(fd, &st) != 0){
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "MappedFile: cannot stat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if(size_ > 0){
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p == MAP_FAILED){
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "MappedFile: cannot map " + path);
+            }
+            // Read ahead aggressively, pages are touched front to back in every part
+            ::madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+            mapped_ = true;
+        }
+        // The mapping keeps the file alive
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if(!in){
+            throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory),
+                                    "MappedFile: cannot open " + path);
+        }
+        size_ = static_cast<std::size_t>(in.tellg());
+        copy_ = std::make_unique_for_overwrite<char[]>(size_ > 0 ? size_ : 1);
+        in.seekg(0);
+        in.read(copy_.get(), static_cast<std::streamsize>(size_));
+        data_ = copy_.get();
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile(){
+#if defined(__unix__) || defined(__APPLE__)
+        if(mapped_){
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    std::string_view text() const{
+        return {data_, size_};
+    }
+    std::size_t size() const{
+        return size_;
+    }
+
+    private:
+    const char* data_ = "";
+    std::size_t size_ = 0;
+    [[maybe_unused]] bool mapped_ = false;
+    std::unique_ptr<char[]> copy_;
+};
+
+// Line-aligned chunks of about chunkSize bytes of one part of text
+// Part k of n starts at the first line starting at or after k * size / n, so n producers
+// with parts 0..n-1 cover every line exactly once without talking to each other
+// Every chunk ends right after a '\n' (or at the end of text); a line longer than chunkSize makes a longer chunk
+class LineChunks{
+    public:
+    LineChunks(std::string_view text, std::size_t chunkSize, std::size_t part = 0, std::size_t parts = 1)
+        : begin_(text.data()), end_(text.data() + text.size()), chunk_(chunkSize == 0 ? 1 : chunkSize){
+        parts = parts == 0 ? 1 : parts;
+        pos_ = lineStart(text.size() / parts * part);
+        last_ = part + 1 >= parts ? end_ : lineStart(text.size() / parts * (part + 1));
+    }
+
+    // Next chunk of the part, false when the part is done
+    bool next(std::string_view& chunk){
+        if(pos_ >= last_){
+            return false;
+        }
+        const char* stop = last_;
+        if(static_cast<std::size_t>(last_ - pos_) > chunk_){
+            // Include the '\n' at or after the chunk size
+            const char* nl = findNewline(pos_ + chunk_ - 1, last_);
+            stop = nl == last_ ? last_ : nl + 1;
+        }
+        chunk = std::string_view(pos_, static_cast<std::size_t>(stop - pos_));
+        pos_ = stop;
+        return true;
+    }
+
+    private:
+    // First line start at or after offset
+    const char* lineStart(std::size_t offset) const{
+        if(offset == 0){
+            return begin_;
+        }
+        const char* nl = findNewline(begin_ + offset - 1, end_);
+        return nl == end_ ? end_ : nl + 1;
+    }
+
+    const char* begin_;
+    const char* end_;
+    std::size_t chunk_;
+    const char* pos_;
+    const char* last_;
+};
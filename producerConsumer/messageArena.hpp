@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Slab arena for message payloads, one per producer
+// - the producer writes a payload once, in place, at the end of its current slab
+//   (compose() formats strings and integers straight into it, no temporary strings)
+// - the consumer gets a Message: a view into the slab plus a handle that releases it
+// - a slab is reused as a whole once it is full and every message in it is released,
+//   so steady-state traffic allocates nothing and never frees memory on another thread
+// Reference counting costs one atomic decrement per message on the consumer side:
+// the producer counts issued messages in a plain variable and adds them to the slab
+// counter once, when it leaves the slab; whoever brings the counter to zero recycles it
+// Only the owning thread may call compose / write; messages may be released on any thread
+// and must all be released before the arena is destroyed
+class MessageArena{
+    struct Slab;
+
+    public:
+    // Handle to one payload; move-only, releases its slab share when destroyed
+    class Message{
+        public:
+        Message() = default;
+        Message(Message&& other) noexcept
+            : slab_(std::exchange(other.slab_, nullptr)), data_(other.data_), size_(other.size_){}
+        Message& operator=(Message&& other) noexcept{
+            if(this != &other){
+                release();
+                slab_ = std::exchange(other.slab_, nullptr);
+                data_ = other.data_;
+                size_ = other.size_;
+            }
+            return *this;
+        }
+        Message(const Message&) = delete;
+        Message& operator=(const Message&) = delete;
+        ~Message(){
+            release();
+        }
+
+        std::string_view view() const{
+            return {data_, size_};
+        }
+        // Acknowledge the payload: the view is invalid afterwards
+        void release(){
+            if(slab_ != nullptr){
+                std::exchange(slab_, nullptr)->release();
+            }
+        }
+
+        private:
+        friend class MessageArena;
+        Message(Slab* slab, const char* data, std::size_t size) : slab_(slab), data_(data), size_(size){}
+
+        Slab* slab_ = nullptr;
+        const char* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+
+    struct Stats{
+        std::size_t messages = 0;
+        // Slabs allocated from the heap / taken from the recycled list
+        std::size_t slabsAllocated = 0;
+        std::size_t slabsReused = 0;
+    };
+
+    explicit MessageArena(std::size_t slabSize = 64 * 1024) : slabSize_(std::max<std::size_t>(slabSize, 64)){}
+    MessageArena(const MessageArena&) = delete;
+    MessageArena& operator=(const MessageArena&) = delete;
+
+    // Concatenate the parts (anything convertible to string_view, chars and integers) into one message
+    template<typename... Parts>
+    Message compose(const Parts&... parts){
+        std::size_t max = (maxLength(parts) + ... + 0);
+        return write(max, [&](char* dst){
+            char* p = dst;
+            ((p = append(p, parts)), ...);
+            return static_cast<std::size_t>(p - dst);
+        });
+    }
+
+    // Reserve max bytes, let fill(char*) write the payload and return its length (<= max)
+    template<typename F>
+    Message write(std::size_t max, F&& fill){
+        if(current_ == nullptr || current_->capacity - used_ < max){
+            nextSlab(max);
+        }
+        char* dst = current_->data.get() + used_;
+        std::size_t n = std::forward<F>(fill)(dst);
+        used_ += n;
+        issued_++;
+        stats_.messages++;
+        return Message(current_, dst, n);
+    }
+
+    Stats stats() const{
+        return stats_;
+    }
+
+    private:
+    struct Slab{
+        // Released minus issued messages while the producer fills the slab (<= 0),
+        // outstanding messages after it has left it
+        alignas(64) std::atomic<std::ptrdiff_t> refs{0};
+        Slab* next = nullptr;
+        MessageArena* owner = nullptr;
+        std::size_t capacity = 0;
+        std::unique_ptr<char[]> data;
+
+        void release(){
+            if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                owner->recycle(this);
+            }
+        }
+    };
+
+    // Leave the current slab and continue in a recycled or a new one with room for at least need bytes
+    void nextSlab(std::size_t need){
+        if(current_ != nullptr){
+            auto issued = static_cast<std::ptrdiff_t>(issued_);
+            if(current_->refs.fetch_add(issued, std::memory_order_acq_rel) + issued == 0){
+                // Every message is already released
+                current_->next = free_;
+                free_ = current_;
+            }
+            current_ = nullptr;
+        }
+        if(free_ == nullptr){
+            // Take everything the consumers have given back with one exchange
+            free_ = recycled_.exchange(nullptr, std::memory_order_acquire);
+        }
+        // Usually the head fits, a slab smaller than an oversized message stays on the list
+        for(Slab** s = &free_; *s != nullptr; s = &(*s)->next){
+            if((*s)->capacity >= need){
+                current_ = *s;
+                *s = current_->next;
+                stats_.slabsReused++;
+                break;
+            }
+        }
+        if(current_ == nullptr){
+            auto slab = std::make_unique<Slab>();
+            slab->owner = this;
+            slab->capacity = std::max(need, slabSize_);
+            slab->data = std::make_unique_for_overwrite<char[]>(slab->capacity);
+            current_ = slab.get();
+            slabs_.push_back(std::move(slab));
+            stats_.slabsAllocated++;
+        }
+        current_->refs.store(0, std::memory_order_relaxed);
+        current_->next = nullptr;
+        used_ = 0;
+        issued_ = 0;
+    }
+
+    // Called by the thread releasing the last message of a slab the producer has left
+    void recycle(Slab* slab){
+        auto head = recycled_.load(std::memory_order_relaxed);
+        do{
+            slab->next = head;
+        }while(!recycled_.compare_exchange_weak(head, slab, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    template<typename P>
+    static std::size_t maxLength(const P& part){
+        if constexpr(std::is_same_v<P, char>){
+            return 1;
+        }
+        else if constexpr(std::is_integral_v<P>){
+            return std::numeric_limits<P>::digits10 + 2;
+        }
+        else{
+            return std::string_view(part).size();
+        }
+    }
+    template<typename P>
+    static char* append(char* p, const P& part){
+        if constexpr(std::is_same_v<P, char>){
+            *p = part;
+            return p + 1;
+        }
+        else if constexpr(std::is_integral_v<P>){
+            return std::to_chars(p, p + maxLength(part), part).ptr;
+        }
+        else{
+            std::string_view s(part);
+            std::memcpy(p, s.data(), s.size());
+            return p + s.size();
+        }
+    }
+
+    std::size_t slabSize_;
+    // Producer state
+    Slab* current_ = nullptr;
+    std::size_t used_ = 0;
+    std::size_t issued_ = 0;
+    Slab* free_ = nullptr;
+    Stats stats_;
+    std::vector<std::unique_ptr<Slab>> slabs_;
+    // Slabs given back by consumers (a stack, the producer takes the whole list at once)
+    alignas(64) std::atomic<Slab*> recycled_{nullptr};
+};
@@ -0,0 +1,72 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mpmcQueue.hpp"
+#include "mutexQueue.hpp"
+
+// Throughput of MpmcQueue vs the mutex + deque + two condition variables scheme of the original demo
+// Every producer pushes its share of items, consumers pop until the queue is closed and drained
+// Usage: mpmcBench [items] [capacity]
+
+// Millions of items per second through the queue
+template<typename Queue>
+double run(std::size_t producers, std::size_t consumers, std::size_t items, std::size_t capacity){
+    Queue queue(capacity);
+    std::vector<std::uint64_t> sums(consumers);
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        std::vector<std::jthread> con;
+        for(std::size_t c = 0; c < consumers; c++){
+            con.emplace_back([&queue, &sums, c]{
+                std::uint64_t item, sum = 0;
+                while(queue.pop(item)){
+                    sum += item;
+                }
+                sums[c] = sum;
+            });
+        }
+        {
+            std::vector<std::jthread> prod;
+            for(std::size_t p = 0; p < producers; p++){
+                prod.emplace_back([&queue, p, producers, items]{
+                    for(std::size_t i = p; i < items; i += producers){
+                        queue.push(static_cast<std::uint64_t>(i));
+                    }
+                });
+            }
+        }
+        queue.close();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::uint64_t sum = 0;
+    for(auto s : sums){
+        sum += s;
+    }
+    if(sum != static_cast<std::uint64_t>(items) * (items - 1) / 2){
+        std::cout << "Lost items!\n";
+    }
+    std::chrono::duration<double> sec = end - start;
+    return static_cast<double>(items) / sec.count() / 1e6;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t items = 2'000'000, capacity = 1024;
+    if(argc > 1){
+        items = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        capacity = std::stoul(argv[2]);
+    }
+    std::cout << items << " items, capacity " << capacity << "\n"
+              << "producers x consumers | mutex+deque Mops/s | MpmcQueue Mops/s\n";
+    const std::size_t shapes[][2] = {{1, 1}, {2, 2}, {4, 4}, {8, 8}, {1, 4}, {4, 1}};
+    for(auto& s : shapes){
+        auto m = run<MutexQueue<std::uint64_t>>(s[0], s[1], items, capacity);
+        auto l = run<MpmcQueue<std::uint64_t>>(s[0], s[1], items, capacity);
+        std::cout << s[0] << " x " << s[1] << " | " << m << " | " << l << std::endl;
+    }
+}
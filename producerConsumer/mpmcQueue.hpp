@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "eventCount.hpp"
+
+// Bounded multi-producer multi-consumer queue (Dmitry Vyukov's ring with per-slot sequence numbers)
+// - capacity is rounded up to a power of two, so a position maps to a slot with a mask
+// - every slot has a sequence number telling whose turn it is:
+//   seq == pos       - free for the producer of position pos
+//   seq == pos + 1   - filled, ready for the consumer of position pos
+//   a producer or consumer claims a position with one CAS and then owns the slot exclusively
+// - try_push / try_pop never block; push / pop sleep on an EventCount (std::atomic::wait) when the queue is full / empty
+// - close() wakes all sleepers: push fails from then on, pop drains the rest and then fails
+//   (call it after the last push has returned, an item published concurrently with close() may be missed)
+template<typename T>
+class MpmcQueue{
+    public:
+    explicit MpmcQueue(std::size_t capacity)
+        : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+          cells_(std::make_unique<Cell[]>(mask_ + 1)){
+        for(std::size_t i = 0; i <= mask_; i++){
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+    ~MpmcQueue(){
+        // Nobody pushes or pops any more, every position in [dequeuePos_, enqueuePos_) holds an item
+        auto last = enqueuePos_.load(std::memory_order_relaxed);
+        for(auto pos = dequeuePos_.load(std::memory_order_relaxed); pos != last; pos++){
+            std::launder(reinterpret_cast<T*>(cells_[pos & mask_].storage))->~T();
+        }
+    }
+
+    // Put the item if there is a free slot
+    template<typename U>
+    bool try_push(U&& item){
+        auto pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while(true){
+            cell = &cells_[pos & mask_];
+            auto seq = cell->seq.load(std::memory_order_acquire);
+            auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if(dif == 0){
+                if(enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+            else if(dif < 0){
+                // The slot still holds the item of the previous round: the queue is full
+                return false;
+            }
+            else{
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (static_cast<void*>(cell->storage)) T(std::forward<U>(item));
+        cell->seq.store(pos + 1, std::memory_order_release);
+        notEmpty_.notify();
+        return true;
+    }
+
+    // Take the oldest item if there is one
+    bool try_pop(T& item){
+        auto pos = dequeuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while(true){
+            cell = &cells_[pos & mask_];
+            auto seq = cell->seq.load(std::memory_order_acquire);
+            auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if(dif == 0){
+                if(dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+            else if(dif < 0){
+                // The slot is not filled yet: the queue is empty
+                return false;
+            }
+            else{
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        auto* p = std::launder(reinterpret_cast<T*>(cell->storage));
+        item = std::move(*p);
+        p->~T();
+        // Free the slot for the producer of the next round
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        notFull_.notify();
+        return true;
+    }
+
+    // Put the item, sleep while the queue is full
+    // Returns false if the queue is closed
+    template<typename U>
+    bool push(U&& item){
+        while(true){
+            if(closed_.load(std::memory_order_acquire)){
+                return false;
+            }
+            auto epoch = notFull_.prepare();
+            if(try_push(std::forward<U>(item))){
+                return true;
+            }
+            notFull_.announce();
+            if(try_push(std::forward<U>(item))){
+                return true;
+            }
+            if(!closed_.load(std::memory_order_acquire)){
+                notFull_.wait(epoch);
+            }
+        }
+    }
+
+    // Take the oldest item, sleep while the queue is empty
+    // Returns false if the queue is closed and empty
+    bool pop(T& item){
+        while(true){
+            auto epoch = notEmpty_.prepare();
+            if(try_pop(item)){
+                return true;
+            }
+            if(closed_.load(std::memory_order_acquire)){
+                // Items pushed before close() are visible now
+                return try_pop(item);
+            }
+            notEmpty_.announce();
+            if(try_pop(item)){
+                return true;
+            }
+            if(!closed_.load(std::memory_order_acquire)){
+                notEmpty_.wait(epoch);
+            }
+        }
+    }
+
+    // Refuse new items and wake everybody sleeping in push / pop
+    void close(){
+        closed_.store(true, std::memory_order_release);
+        notEmpty_.notifyAll();
+        notFull_.notifyAll();
+    }
+
+    bool closed() const{
+        return closed_.load(std::memory_order_acquire);
+    }
+    std::size_t capacity() const{
+        return mask_ + 1;
+    }
+    // Approximate number of items (exact when nobody pushes or pops)
+    std::size_t size() const{
+        auto head = dequeuePos_.load(std::memory_order_relaxed);
+        auto tail = enqueuePos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    private:
+    struct Cell{
+        std::atomic<std::size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    // Producers and consumers work on different ends, keep the positions on different cache lines
+    alignas(64) std::atomic<std::size_t> enqueuePos_{0};
+    alignas(64) std::atomic<std::size_t> dequeuePos_{0};
+    // Sleeping consumers and producers
+    alignas(64) EventCount notEmpty_;
+    alignas(64) EventCount notFull_;
+    alignas(64) std::atomic<bool> closed_{false};
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// Queue of the original producerConsumer.cpp demo: deque + mutex + two condition variables
+// Every push and pop takes the mutex; kept as the baseline for the benchmarks
+template<typename T>
+class MutexQueue{
+    public:
+    explicit MutexQueue(std::size_t capacity) : capacity_(capacity){}
+
+    bool push(T item){
+        std::unique_lock<std::mutex> lk(mut_);
+        notFull_.wait(lk, [this]{return deq_.size() < capacity_ || closed_;});
+        if(closed_){
+            return false;
+        }
+        deq_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+    bool pop(T& item){
+        std::unique_lock<std::mutex> lk(mut_);
+        notEmpty_.wait(lk, [this]{return !deq_.empty() || closed_;});
+        if(deq_.empty()){
+            return false;
+        }
+        item = std::move(deq_.front());
+        deq_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+    void close(){
+        {
+            std::lock_guard<std::mutex> lk(mut_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    private:
+    std::size_t capacity_;
+    std::deque<T> deq_;
+    std::mutex mut_;
+    std::condition_variable notFull_, notEmpty_;
+    bool closed_ = false;
+};
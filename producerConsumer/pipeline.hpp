@@ -0,0 +1,420 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "boundedChannel.hpp"
+
+// Whether a stage with several workers keeps the order of the source
+enum class StageOrder{
+    Unordered,
+    Ordered
+};
+
+// Chain of producer/consumer hops: a source, any number of stages and a sink,
+// every hop connected to the next one by a BoundedChannel
+//
+//   auto pipeline = Pipeline::source<int>("read", [](std::stop_token st, auto& emit){...})
+//                       .stage("parse", 4, StageOrder::Ordered, [](int x){return ...;})
+//                       .sink("write", 1, [](std::string s){...});
+//   pipeline.run();
+//
+// - the source calls emit(value) for every item; emit returns false once the pipeline is cancelled
+// - a stage maps one item to exactly one item on its own workers; an Ordered stage passes the
+//   results on in source order (a reorder buffer holds results that overtook a slower one)
+// - end of stream: the last worker leaving a stage requests stop on the stop_source of the next stage,
+//   whose stop_callback closes its input channel; the workers drain it and leave in turn
+// - stop() requests stop on the token the source gets, the items already emitted still flow through
+// - an exception thrown by a stage function drops that item and cancels the source, wait() rethrows the first one
+// - per stage: items, time spent in the function (busy), waiting for input (starved) and waiting for
+//   room in the next channel (blocked); the stage with the highest busy share is the bottleneck
+// Item types must be default-constructible and movable
+class Pipeline{
+    public:
+    template<typename T>
+    class Builder;
+
+    struct StageStats{
+        std::string name;
+        std::size_t workers = 0;
+        std::uint64_t items = 0;
+        // Seconds summed over the workers of the stage
+        double busy = 0;
+        double inputWait = 0;
+        double outputWait = 0;
+    };
+
+    template<typename T, typename F>
+    static Builder<T> source(std::string name, F&& f, std::size_t capacity = 256);
+
+    Pipeline(Pipeline&&) = default;
+    Pipeline& operator=(Pipeline&&) = delete;
+    // Never throws: stage errors not taken by wait() are dropped
+    ~Pipeline(){
+        stop();
+        join();
+    }
+
+    void start(){
+        start_ = Clock::now();
+        for(auto& s : stages_){
+            s->start();
+        }
+    }
+    // Join every worker; rethrows the first exception of a stage function and drops the others
+    void wait(){
+        join();
+        std::exception_ptr first;
+        for(auto& s : stages_){
+            if(auto e = std::exchange(s->error, nullptr); e && !first){
+                first = e;
+            }
+        }
+        if(first){
+            std::rethrow_exception(first);
+        }
+    }
+    void run(){
+        start();
+        wait();
+    }
+    // Ask the source to stop emitting, the rest of the pipeline drains
+    void stop(){
+        cancel_.request_stop();
+    }
+
+    // Counters so far (final after wait())
+    std::vector<StageStats> stats() const{
+        std::vector<StageStats> result;
+        for(auto& s : stages_){
+            result.push_back(StageStats{s->name, s->workers, s->items.load(std::memory_order_relaxed),
+                                        s->busyNs.load(std::memory_order_relaxed) / 1e9,
+                                        s->inputNs.load(std::memory_order_relaxed) / 1e9,
+                                        s->outputNs.load(std::memory_order_relaxed) / 1e9});
+        }
+        return result;
+    }
+
+    // Table of the stages, shares are relative to workers x wall time
+    std::string report() const{
+        auto end = end_ == Clock::time_point{} ? Clock::now() : end_;
+        double wall = std::chrono::duration<double>(end - start_).count();
+        auto all = stats();
+        std::size_t bottleneck = 0;
+        for(std::size_t i = 1; i < all.size(); i++){
+            if(all[i].busy / all[i].workers > all[bottleneck].busy / all[bottleneck].workers){
+                bottleneck = i;
+            }
+        }
+        std::ostringstream ss;
+        ss << "stage | workers | items/s | busy % | starved % | blocked %\n";
+        for(std::size_t i = 0; i < all.size(); i++){
+            auto& s = all[i];
+            double share = 100.0 / (wall * static_cast<double>(s.workers));
+            ss << s.name << " | " << s.workers << " | " << static_cast<double>(s.items) / wall << " | "
+               << s.busy * share << " | " << s.inputWait * share << " | " << s.outputWait * share
+               << (i == bottleneck ? " <- bottleneck" : "") << "\n";
+        }
+        return ss.str();
+    }
+
+    private:
+    using Clock = std::chrono::steady_clock;
+    // Items read from the input channel at once
+    static constexpr std::size_t batch = 16;
+    // Counters are published every that many items
+    static constexpr std::uint64_t publishEvery = 256;
+
+    template<typename T>
+    struct Item{
+        std::uint64_t seq = 0;
+        T value{};
+    };
+    template<typename T>
+    using Channel = BoundedChannel<Item<T>>;
+
+    // Per-worker counters, added to the stage atomics from time to time
+    struct Counters{
+        std::uint64_t items = 0;
+        std::uint64_t busy = 0;
+        std::uint64_t input = 0;
+        std::uint64_t output = 0;
+        Clock::time_point last = Clock::now();
+
+        // Nanoseconds since the previous call
+        std::uint64_t lap(){
+            auto now = Clock::now();
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+            last = now;
+            return static_cast<std::uint64_t>(ns);
+        }
+    };
+
+    struct StageBase{
+        StageBase(std::string n, std::size_t w, std::stop_source c)
+            : name(std::move(n)), workers(w == 0 ? 1 : w), cancel(std::move(c)){}
+        virtual ~StageBase() = default;
+
+        // Body of one worker
+        virtual void work() = 0;
+        // Run by the last worker leaving the stage
+        virtual void finish(){}
+
+        void start(){
+            running.store(workers, std::memory_order_relaxed);
+            for(std::size_t i = 0; i < workers; i++){
+                threads.emplace_back([this]{
+                    work();
+                    if(running.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                        finish();
+                        if(next != nullptr){
+                            next->eos.request_stop();
+                        }
+                    }
+                });
+            }
+        }
+        void publish(Counters& c){
+            items.fetch_add(c.items, std::memory_order_relaxed);
+            busyNs.fetch_add(c.busy, std::memory_order_relaxed);
+            inputNs.fetch_add(c.input, std::memory_order_relaxed);
+            outputNs.fetch_add(c.output, std::memory_order_relaxed);
+            c.items = c.busy = c.input = c.output = 0;
+        }
+        void fail(std::exception_ptr e){
+            {
+                std::lock_guard<std::mutex> lk(errorMtx);
+                if(!error){
+                    error = e;
+                }
+            }
+            cancel.request_stop();
+        }
+
+        std::string name;
+        std::size_t workers;
+        std::stop_source cancel;
+        // Requested by the previous stage when its output is complete
+        std::stop_source eos;
+        StageBase* next = nullptr;
+        std::atomic<std::size_t> running{0};
+        std::atomic<std::uint64_t> items{0}, busyNs{0}, inputNs{0}, outputNs{0};
+        std::mutex errorMtx;
+        std::exception_ptr error;
+        std::vector<std::jthread> threads;
+    };
+
+    template<typename T, typename F>
+    struct SourceStage : StageBase{
+        SourceStage(std::string n, std::stop_source c, F f, std::size_t capacity)
+            : StageBase(std::move(n), 1, std::move(c)), fn(std::move(f)), out(capacity){}
+
+        void work() override{
+            Counters c;
+            std::uint64_t seq = 0;
+            auto token = cancel.get_token();
+            auto emit = [&](T value){
+                if(token.stop_requested()){
+                    return false;
+                }
+                c.busy += c.lap();
+                bool pushed = out.push(Item<T>{seq++, std::move(value)});
+                c.output += c.lap();
+                if(++c.items == publishEvery){
+                    publish(c);
+                }
+                return pushed;
+            };
+            try{
+                fn(token, emit);
+            }
+            catch(...){
+                fail(std::current_exception());
+            }
+            c.busy += c.lap();
+            publish(c);
+        }
+
+        F fn;
+        Channel<T> out;
+    };
+
+    // Stage with an input channel; Out == void is the sink
+    template<typename In, typename Out, typename F>
+    struct MapStage : StageBase{
+        // Output item type, a placeholder for the sink
+        using Value = std::conditional_t<std::is_void_v<Out>, char, Out>;
+
+        MapStage(std::string n, std::size_t w, std::stop_source c, Channel<In>& input, StageOrder o, F f,
+                 std::size_t capacity)
+            : StageBase(std::move(n), w, std::move(c)), in(input), order(o), fn(std::move(f)), out(makeOutput(capacity)),
+              onEos(eos.get_token(), [this]{in.close();}){}
+
+        void work() override{
+            Counters c;
+            std::vector<Item<In>> buf(batch);
+            [[maybe_unused]] std::vector<Item<Value>> results;
+            while(true){
+                auto n = in.pop_n(buf.begin(), batch);
+                c.input += c.lap();
+                if(n == 0){
+                    break;
+                }
+                for(std::size_t i = 0; i < n; i++){
+                    try{
+                        if constexpr(std::is_void_v<Out>){
+                            fn(std::move(buf[i].value));
+                        }
+                        else{
+                            results.push_back(Item<Value>{buf[i].seq, fn(std::move(buf[i].value))});
+                        }
+                    }
+                    catch(...){
+                        fail(std::current_exception());
+                    }
+                }
+                c.busy += c.lap();
+                if constexpr(!std::is_void_v<Out>){
+                    deliver(results);
+                    results.clear();
+                    c.output += c.lap();
+                }
+                c.items += n;
+                if(c.items >= publishEvery){
+                    publish(c);
+                }
+            }
+            publish(c);
+        }
+
+        void finish() override{
+            if constexpr(!std::is_void_v<Out>){
+                // Results behind a dropped item (an exception upstream or here)
+                std::vector<Item<Value>> rest;
+                for(auto& [seq, value] : pending){
+                    rest.push_back(Item<Value>{seq, std::move(value)});
+                }
+                pending.clear();
+                out->push_n(rest.begin(), rest.size());
+            }
+        }
+
+        // Pass results on, in source order for an Ordered stage
+        void deliver(std::vector<Item<Value>>& results){
+            if(order == StageOrder::Unordered){
+                out->push_n(results.begin(), results.size());
+                return;
+            }
+            std::lock_guard<std::mutex> lk(reorderMtx);
+            for(auto& r : results){
+                pending.emplace(r.seq, std::move(r.value));
+            }
+            results.clear();
+            for(auto it = pending.begin(); it != pending.end() && it->first == nextSeq; it = pending.erase(it)){
+                results.push_back(Item<Value>{nextSeq++, std::move(it->second)});
+            }
+            // Pushed under the lock, so batches of consecutive results cannot overtake each other
+            out->push_n(results.begin(), results.size());
+        }
+
+        static auto makeOutput(std::size_t capacity){
+            if constexpr(std::is_void_v<Out>){
+                return nullptr;
+            }
+            else{
+                return std::make_unique<Channel<Out>>(capacity);
+            }
+        }
+
+        Channel<In>& in;
+        StageOrder order;
+        F fn;
+        decltype(makeOutput(0)) out;
+        // Reorder buffer of an Ordered stage
+        std::mutex reorderMtx;
+        std::map<std::uint64_t, Value> pending;
+        std::uint64_t nextSeq = 0;
+        std::stop_callback<std::function<void()>> onEos;
+    };
+
+    Pipeline() = default;
+
+    void join(){
+        for(auto& s : stages_){
+            for(auto& t : s->threads){
+                if(t.joinable()){
+                    t.join();
+                }
+            }
+        }
+        if(end_ == Clock::time_point{}){
+            end_ = Clock::now();
+        }
+    }
+
+    template<typename S>
+    S& add(std::unique_ptr<S> stage){
+        auto& s = *stage;
+        if(!stages_.empty()){
+            stages_.back()->next = &s;
+        }
+        stages_.push_back(std::move(stage));
+        return s;
+    }
+
+    std::stop_source cancel_;
+    std::vector<std::unique_ptr<StageBase>> stages_;
+    Clock::time_point start_{}, end_{};
+};
+
+// Pipeline under construction whose last stage produces T
+template<typename T>
+class Pipeline::Builder{
+    public:
+    // f(T) -> U runs on workers threads
+    template<typename F>
+    auto stage(std::string name, std::size_t workers, StageOrder order, F&& f, std::size_t capacity = 256){
+        using U = std::invoke_result_t<std::decay_t<F>&, T&&>;
+        auto& s = pipeline_.add(std::make_unique<MapStage<T, U, std::decay_t<F>>>(
+            std::move(name), workers, pipeline_.cancel_, *out_, order, std::forward<F>(f), capacity));
+        return Builder<U>(std::move(pipeline_), s.out.get());
+    }
+
+    // f(T) consumes the items on workers threads
+    // (one worker after an Ordered stage sees the items in source order)
+    template<typename F>
+    Pipeline sink(std::string name, std::size_t workers, F&& f){
+        pipeline_.add(std::make_unique<MapStage<T, void, std::decay_t<F>>>(
+            std::move(name), workers, pipeline_.cancel_, *out_, StageOrder::Unordered, std::forward<F>(f), 0));
+        return std::move(pipeline_);
+    }
+
+    private:
+    friend class Pipeline;
+    Builder(Pipeline pipeline, Channel<T>* out) : pipeline_(std::move(pipeline)), out_(out){}
+
+    Pipeline pipeline_;
+    Channel<T>* out_;
+};
+
+// f(std::stop_token, emit) calls emit(T) for every item and returns at the end of the input
+template<typename T, typename F>
+Pipeline::Builder<T> Pipeline::source(std::string name, F&& f, std::size_t capacity){
+    Pipeline pipeline;
+    auto& s = pipeline.add(std::make_unique<SourceStage<T, std::decay_t<F>>>(
+        std::move(name), pipeline.cancel_, std::forward<F>(f), capacity));
+    return Builder<T>(std::move(pipeline), &s.out);
+}
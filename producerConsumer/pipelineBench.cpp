@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "pipeline.hpp"
+
+// Four-stage pipeline: generate text records -> parse -> hash (expensive) -> aggregate
+// The hash stage runs on 1, 2, 4, ... workers, the per-stage report shows the bottleneck moving
+// from the hash stage to the cheaper ones; then Ordered and Unordered hashing are compared
+// First checks that stage errors are reported once and never terminate (exit code 1 otherwise)
+// Usage: pipelineBench [records] [hash rounds]
+
+struct Record{
+    std::uint64_t id = 0;
+    std::uint64_t value = 0;
+};
+
+std::uint64_t mix(std::uint64_t x, std::size_t rounds){
+    for(std::size_t i = 0; i < rounds; i++){
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 29;
+    }
+    return x;
+}
+
+struct Outcome{
+    double seconds;
+    bool inOrder;
+    std::string report;
+};
+
+Outcome run(std::size_t records, std::size_t rounds, std::size_t hashWorkers, StageOrder order){
+    bool inOrder = true;
+    std::uint64_t lastId = 0, checksum = 0;
+    auto pipeline = Pipeline::source<std::string>("generate", [records](std::stop_token, auto& emit){
+            for(std::size_t i = 0; i < records; i++){
+                if(!emit(std::to_string(i) + "," + std::to_string(i * 7919))){
+                    break;
+                }
+            }
+        })
+        .stage("parse", 2, StageOrder::Ordered, [](std::string line){
+            auto comma = line.find(',');
+            return Record{std::stoull(line.substr(0, comma)), std::stoull(line.substr(comma + 1))};
+        })
+        .stage("hash", hashWorkers, order, [rounds](Record r){
+            r.value = mix(r.value, rounds);
+            return r;
+        })
+        .sink("aggregate", 1, [&](Record r){
+            if(r.id < lastId){
+                inOrder = false;
+            }
+            lastId = r.id;
+            checksum += r.value;
+        });
+    auto start = std::chrono::steady_clock::now();
+    pipeline.run();
+    std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+    return Outcome{sec.count(), inOrder, pipeline.report()};
+}
+
+// Source of 0..records-1 into a stage that throws on item 3 and a sink that throws on item 1
+Pipeline failing(std::size_t records){
+    return Pipeline::source<int>("count", [records](std::stop_token, auto& emit){
+            for(std::size_t i = 0; i < records; i++){
+                if(!emit(static_cast<int>(i))){
+                    break;
+                }
+            }
+        })
+        .stage("stage", 2, StageOrder::Unordered, [](int x){
+            if(x == 3){
+                throw std::runtime_error("stage failed");
+            }
+            return x;
+        })
+        .sink("sink", 1, [](int x){
+            if(x == 1){
+                throw std::runtime_error("sink failed");
+            }
+        });
+}
+
+// Two throwing stages: run() throws once, the destructor does not; start() without wait(): nothing throws
+bool checkErrors(){
+    bool ok = true;
+    try{
+        failing(1000).run();
+        std::cout << "error check: run() did not throw\n";
+        ok = false;
+    }
+    catch(const std::runtime_error&){
+    }
+    try{
+        auto pipeline = failing(1000);
+        pipeline.start();
+    }
+    catch(...){
+        std::cout << "error check: start() then destroy threw\n";
+        ok = false;
+    }
+    {
+        auto pipeline = failing(1000);
+        try{
+            pipeline.run();
+        }
+        catch(const std::runtime_error&){
+        }
+        try{
+            pipeline.wait();
+        }
+        catch(...){
+            std::cout << "error check: second wait() rethrew\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]){
+    if(!checkErrors()){
+        return 1;
+    }
+    std::size_t records = 200'000, rounds = 2000;
+    if(argc > 1){
+        records = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        rounds = std::stoul(argv[2]);
+    }
+    auto maxWorkers = std::max(2u, std::thread::hardware_concurrency());
+    std::cout << records << " records, " << rounds << " hash rounds\n";
+    for(std::size_t w = 1; w <= maxWorkers; w *= 2){
+        auto r = run(records, rounds, w, StageOrder::Ordered);
+        std::cout << "\nhash workers " << w << ": " << static_cast<double>(records) / r.seconds / 1e6
+                  << " Mrecords/s" << (r.inOrder ? "" : " (order lost!)") << "\n" << r.report;
+    }
+    std::cout << "\nOrdered vs Unordered hash stage, " << maxWorkers << " workers\n";
+    for(auto order : {StageOrder::Ordered, StageOrder::Unordered}){
+        auto r = run(records, rounds, maxWorkers, order);
+        std::cout << (order == StageOrder::Ordered ? "Ordered  " : "Unordered") << ": "
+                  << static_cast<double>(records) / r.seconds / 1e6 << " Mrecords/s, sink saw source order: "
+                  << (r.inOrder ? "yes" : "no") << std::endl;
+    }
+}
@@ -1,51 +1,79 @@
-#include <condition_variable>
 #include <cstddef>
-#include <deque>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sstream>
-#include <stop_token>
 #include <string>
 #include <thread>
+#include <vector>
+#include "messageArena.hpp"
+#include "mpmcQueue.hpp"
 
-constexpr std::size_t N = 5;
-constexpr std::chrono::milliseconds max_wait{100};
-std::deque<std::string> deq;
-std::mutex mut;
-std::condition_variable notFull, notEmpty;
+// N producers and M consumers sharing one bounded lock-free queue
+// Every producer writes its payloads into its own MessageArena, the queue carries handles
+// Usage: producerConsumer [producers] [consumers]
 
-void producer(){
+using Message = MessageArena::Message;
+
+constexpr std::size_t N = 8;
+MpmcQueue<Message> queue(N);
+std::mutex coutMtx;
+
+void producer(MessageArena& arena){
     std::ostringstream ss;
     ss << std::this_thread::get_id();
     std::string output = ss.str();
     for(int i = 0; i < 10; i++){
-        std::unique_lock<std::mutex> lk(mut);
-        notFull.wait(lk, []{return deq.size() < N;});
-        deq.push_back(output + " " + std::to_string(i));
-        std::cout << "Write " << output + " " + std::to_string(i) << std::endl;
-        notEmpty.notify_one();
+        // Written once into the arena, no temporary strings
+        Message item = arena.compose(output, ' ', i);
+        {
+            std::lock_guard<std::mutex> lk(coutMtx);
+            std::cout << "Write " << item.view() << std::endl;
+        }
+        // Sleeps while the queue is full
+        queue.push(std::move(item));
     }
 }
 
-void consumer(std::stop_token sToken){
-    while(true){
-        if (sToken.stop_requested() && deq.empty()) {
-            break;
-        }
-        std::unique_lock<std::mutex> lk(mut);
-        notEmpty.wait_for(lk, max_wait, [&sToken]{return !deq.empty() || sToken.stop_requested();});
-        while(!deq.empty()){
-            auto item = std::move(deq.front());
-            deq.pop_front();
-            std::cout << "Read " << item << std::endl;
+void consumer(){
+    std::ostringstream ss;
+    ss << std::this_thread::get_id();
+    std::string output = ss.str();
+    Message item;
+    // Sleeps while the queue is empty, returns false when it is closed and drained
+    while(queue.pop(item)){
+        {
+            std::lock_guard<std::mutex> lk(coutMtx);
+            std::cout << "Read " << item.view() << " in " << output << std::endl;
         }
-        notFull.notify_one();
+        // Acknowledge: the slab is reused once all its messages are released
+        item.release();
     }
 }
 
-int main(){
-    std::thread prod(producer);
-    std::jthread con(consumer);
-    prod.join();
-    con.request_stop();
-}
\ No newline at end of file
+int main(int argc, char* argv[]){
+    std::size_t producers = 2, consumers = 2;
+    if(argc > 1){
+        producers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        consumers = std::stoul(argv[2]);
+    }
+    // Declared before the threads: the arenas outlive every message
+    std::vector<std::unique_ptr<MessageArena>> arenas;
+    for(std::size_t i = 0; i < producers; i++){
+        arenas.push_back(std::make_unique<MessageArena>());
+    }
+    std::vector<std::jthread> prod, con;
+    for(std::size_t i = 0; i < consumers; i++){
+        con.emplace_back(consumer);
+    }
+    for(std::size_t i = 0; i < producers; i++){
+        prod.emplace_back(producer, std::ref(*arenas[i]));
+    }
+    for(auto& t : prod){
+        t.join();
+    }
+    // All items are pushed, consumers drain the queue and leave
+    queue.close();
+}
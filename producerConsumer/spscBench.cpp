@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mutexQueue.hpp"
+#include "spscQueue.hpp"
+
+// One producer and one consumer: SpscQueue vs the deque + condition variable channel of the original demo
+// Throughput: items per second for single push / pop and for batches
+// Ping-pong: round trip of one item through two queues (there and back)
+// Usage: spscBench [items] [round trips] [batch]
+
+using Clock = std::chrono::steady_clock;
+constexpr std::size_t capacity = 1024;
+
+double mops(std::size_t items, Clock::time_point start){
+    std::chrono::duration<double> sec = Clock::now() - start;
+    return static_cast<double>(items) / sec.count() / 1e6;
+}
+
+// Items one by one through a queue with blocking push / pop
+template<typename Queue>
+double throughput(std::size_t items){
+    Queue queue(capacity);
+    std::uint64_t sum = 0;
+    auto start = Clock::now();
+    {
+        std::jthread consumer([&]{
+            std::uint64_t item;
+            while(queue.pop(item)){
+                sum += item;
+            }
+        });
+        for(std::size_t i = 0; i < items; i++){
+            queue.push(static_cast<std::uint64_t>(i));
+        }
+        queue.close();
+    }
+    auto res = mops(items, start);
+    if(sum != static_cast<std::uint64_t>(items) * (items - 1) / 2){
+        std::cout << "Lost items!\n";
+    }
+    return res;
+}
+
+// Items in batches through push_n / pop_n
+double throughputBatch(std::size_t items, std::size_t batch){
+    SpscQueue<std::uint64_t> queue(capacity);
+    std::uint64_t sum = 0;
+    auto start = Clock::now();
+    {
+        std::jthread consumer([&]{
+            std::vector<std::uint64_t> buf(batch);
+            while(auto n = queue.pop_n(buf.begin(), batch)){
+                for(std::size_t i = 0; i < n; i++){
+                    sum += buf[i];
+                }
+            }
+        });
+        std::vector<std::uint64_t> buf(batch);
+        for(std::size_t i = 0; i < items; i += batch){
+            auto n = std::min(batch, items - i);
+            for(std::size_t k = 0; k < n; k++){
+                buf[k] = i + k;
+            }
+            queue.push_n(buf.begin(), n);
+        }
+        queue.close();
+    }
+    auto res = mops(items, start);
+    if(sum != static_cast<std::uint64_t>(items) * (items - 1) / 2){
+        std::cout << "Lost items!\n";
+    }
+    return res;
+}
+
+std::chrono::nanoseconds percentile(std::vector<std::chrono::nanoseconds>& v, double q){
+    return v[static_cast<std::size_t>(q * (v.size() - 1))];
+}
+
+// Round trips of one item: main thread -> echo thread -> main thread
+// Spin == true polls with try_push / try_pop and yield instead of sleeping
+template<typename Queue, bool Spin = false>
+void pingPong(const std::string& name, std::size_t trips){
+    Queue there(capacity), back(capacity);
+    auto send = [](Queue& q, std::uint64_t v){
+        if constexpr(Spin){
+            while(!q.try_push(v)){
+                std::this_thread::yield();
+            }
+        }
+        else{
+            q.push(v);
+        }
+    };
+    auto receive = [](Queue& q, std::uint64_t& v){
+        if constexpr(Spin){
+            while(!q.try_pop(v)){
+                if(q.closed()){
+                    return q.try_pop(v);
+                }
+                std::this_thread::yield();
+            }
+            return true;
+        }
+        else{
+            return q.pop(v);
+        }
+    };
+    std::vector<std::chrono::nanoseconds> rtt(trips);
+    {
+        std::jthread echo([&]{
+            std::uint64_t v;
+            while(receive(there, v)){
+                send(back, v);
+            }
+        });
+        for(std::size_t i = 0; i < trips; i++){
+            auto start = Clock::now();
+            std::uint64_t v = i;
+            send(there, v);
+            receive(back, v);
+            rtt[i] = Clock::now() - start;
+        }
+        there.close();
+    }
+    std::sort(rtt.begin(), rtt.end());
+    std::cout << name << ": p50 = " << percentile(rtt, 0.5).count() << " ns, p99 = "
+              << percentile(rtt, 0.99).count() << " ns" << std::endl;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t items = 5'000'000, trips = 50'000, batch = 64;
+    if(argc > 1){
+        items = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        trips = std::stoul(argv[2]);
+    }
+    if(argc > 3){
+        batch = std::stoul(argv[3]);
+    }
+    std::cout << "Throughput, " << items << " items, capacity " << capacity << "\n"
+              << "deque + cv:            " << throughput<MutexQueue<std::uint64_t>>(items) << " Mops/s\n"
+              << "SpscQueue push/pop:    " << throughput<SpscQueue<std::uint64_t>>(items) << " Mops/s\n"
+              << "SpscQueue batch " << batch << ":    " << throughputBatch(items, batch) << " Mops/s\n";
+    std::cout << "Ping-pong round trip, " << trips << " trips\n";
+    pingPong<MutexQueue<std::uint64_t>>("deque + cv        ", trips);
+    pingPong<SpscQueue<std::uint64_t>>("SpscQueue sleeping", trips);
+    pingPong<SpscQueue<std::uint64_t>, true>("SpscQueue spinning", trips);
+}
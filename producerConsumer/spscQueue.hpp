@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include "eventCount.hpp"
+
+// Bounded single-producer single-consumer ring
+// - try_push / try_pop and the batch versions are wait-free: a fixed number of steps, no CAS
+// - head_ (written by the consumer) and tail_ (written by the producer) live on different cache lines;
+//   every side keeps a cached copy of the other index next to its own one and reloads it only
+//   when the cached value says the ring is full / empty, so in the steady state an item costs
+//   no cache miss on the index of the other side
+// - batch calls publish many items with one release store
+// - push / pop and the batch versions sleep on an EventCount when the ring is full / empty
+// Exactly one thread may push and exactly one thread may pop
+template<typename T>
+class SpscQueue{
+    public:
+    explicit SpscQueue(std::size_t capacity)
+        : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+          slots_(std::make_unique<Slot[]>(mask_ + 1)){}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    ~SpscQueue(){
+        auto tail = tail_.load(std::memory_order_relaxed);
+        for(auto pos = head_.load(std::memory_order_relaxed); pos != tail; pos++){
+            at(pos)->~T();
+        }
+    }
+
+    // Producer side
+
+    template<typename U>
+    bool try_push(U&& item){
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if(tail - cachedHead_ > mask_){
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if(tail - cachedHead_ > mask_){
+                return false;
+            }
+        }
+        ::new (static_cast<void*>(slots_[tail & mask_].storage)) T(std::forward<U>(item));
+        tail_.store(tail + 1, std::memory_order_release);
+        notEmpty_.notify();
+        return true;
+    }
+
+    // Move up to n items from first, returns the number of moved items
+    template<typename It>
+    std::size_t try_push_n(It first, std::size_t n){
+        auto tail = tail_.load(std::memory_order_relaxed);
+        auto free = mask_ + 1 - (tail - cachedHead_);
+        if(free < n){
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            free = mask_ + 1 - (tail - cachedHead_);
+        }
+        n = std::min(n, free);
+        if(n == 0){
+            return 0;
+        }
+        for(std::size_t i = 0; i < n; i++, ++first){
+            ::new (static_cast<void*>(slots_[(tail + i) & mask_].storage)) T(std::move(*first));
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        notEmpty_.notify();
+        return n;
+    }
+
+    // Sleep while full, returns false if the queue is closed
+    template<typename U>
+    bool push(U&& item){
+        return waitFor(notFull_, [&]{return try_push(std::forward<U>(item));});
+    }
+
+    // Move all n items from first, sleeping while full
+    // Returns the number of moved items (less than n only if the queue was closed)
+    template<typename It>
+    std::size_t push_n(It first, std::size_t n){
+        std::size_t done = 0;
+        while(done < n){
+            std::size_t k = 0;
+            if(!waitFor(notFull_, [&]{return (k = try_push_n(first, n - done)) > 0;})){
+                break;
+            }
+            std::advance(first, k);
+            done += k;
+        }
+        return done;
+    }
+
+    // Consumer side
+
+    bool try_pop(T& item){
+        auto head = head_.load(std::memory_order_relaxed);
+        if(head == cachedTail_){
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if(head == cachedTail_){
+                return false;
+            }
+        }
+        auto* p = at(head);
+        item = std::move(*p);
+        p->~T();
+        head_.store(head + 1, std::memory_order_release);
+        notFull_.notify();
+        return true;
+    }
+
+    // Move up to max items to out, returns the number of moved items
+    template<typename OutIt>
+    std::size_t try_pop_n(OutIt out, std::size_t max){
+        auto head = head_.load(std::memory_order_relaxed);
+        if(cachedTail_ - head < max){
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+        }
+        auto n = std::min(max, cachedTail_ - head);
+        if(n == 0){
+            return 0;
+        }
+        for(std::size_t i = 0; i < n; i++, ++out){
+            auto* p = at(head + i);
+            *out = std::move(*p);
+            p->~T();
+        }
+        head_.store(head + n, std::memory_order_release);
+        notFull_.notify();
+        return n;
+    }
+
+    // Sleep while empty, returns false if the queue is closed and drained
+    bool pop(T& item){
+        return waitFor(notEmpty_, [&]{return try_pop(item);}, true);
+    }
+
+    // Sleep while empty, then move up to max items
+    // Returns 0 only if the queue is closed and drained
+    template<typename OutIt>
+    std::size_t pop_n(OutIt out, std::size_t max){
+        std::size_t n = 0;
+        waitFor(notEmpty_, [&]{return (n = try_pop_n(out, max)) > 0;}, true);
+        return n;
+    }
+
+    // Either side
+
+    // The producer will not push any more: wake a sleeping consumer, pop fails once the ring is drained
+    void close(){
+        closed_.store(true, std::memory_order_release);
+        notEmpty_.notifyAll();
+        notFull_.notifyAll();
+    }
+    bool closed() const{
+        return closed_.load(std::memory_order_acquire);
+    }
+    std::size_t capacity() const{
+        return mask_ + 1;
+    }
+
+    private:
+    struct Slot{
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    T* at(std::size_t pos){
+        return std::launder(reinterpret_cast<T*>(slots_[pos & mask_].storage));
+    }
+
+    // Repeat op() until it succeeds, sleeping on ev between attempts
+    // A closed queue stops waiting; the consumer (drain == true) still gets the remaining items
+    template<typename Op>
+    bool waitFor(EventCount& ev, Op&& op, bool drain = false){
+        while(true){
+            if(!drain && closed_.load(std::memory_order_acquire)){
+                return false;
+            }
+            auto epoch = ev.prepare();
+            if(op()){
+                return true;
+            }
+            if(drain && closed_.load(std::memory_order_acquire)){
+                // Everything pushed before close() is visible now
+                return op();
+            }
+            ev.announce();
+            if(op()){
+                return true;
+            }
+            if(!closed_.load(std::memory_order_acquire)){
+                ev.wait(epoch);
+            }
+        }
+    }
+
+    std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    // Consumer line: own index and cached index of the producer
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t cachedTail_ = 0;
+    // Producer line: own index and cached index of the consumer
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t cachedHead_ = 0;
+    // Sleeping consumer and producer
+    alignas(64) EventCount notEmpty_;
+    alignas(64) EventCount notFull_;
+    alignas(64) std::atomic<bool> closed_{false};
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "backoff.hpp"
+
+// Spin-then-park lock
+// - a contended lock() first spins (relaxed reads + pause) for a bounded number of iterations that is
+//   learned from how long the previous acquisitions spun, like glibc's adaptive mutex:
+//   short critical sections are handed over without a context switch
+// - if the lock is still taken it parks in std::atomic::wait (a futex on Linux), so a preempted holder
+//   does not make the waiters burn whole time slices
+// - the state tells unlock() whether anybody may be parked (Drepper's three-state futex mutex):
+//   0 free, 1 locked, 2 locked and maybe waiters; unlock() calls notify_one only after 2
+class AdaptiveLock{
+    public:
+    void lock(){
+        std::uint32_t expected = 0;
+        if(state_.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed)){
+            return;
+        }
+        auto limit = std::min(maxSpins, spins_.load(std::memory_order_relaxed) * 2 + 10);
+        for(std::uint32_t i = 0; i < limit; i++){
+            cpuRelax();
+            if(state_.load(std::memory_order_relaxed) == 0){
+                expected = 0;
+                if(state_.compare_exchange_weak(expected, 1, std::memory_order_acquire, std::memory_order_relaxed)){
+                    learn(i);
+                    return;
+                }
+            }
+        }
+        learn(limit);
+        // Park; whoever takes the lock from here on marks it as contended, so unlock() wakes the next one
+        while(state_.exchange(2, std::memory_order_acquire) != 0){
+            state_.wait(2, std::memory_order_relaxed);
+        }
+    }
+    bool try_lock(){
+        std::uint32_t expected = 0;
+        return state_.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    void unlock(){
+        if(state_.exchange(0, std::memory_order_release) == 2){
+            state_.notify_one();
+        }
+    }
+
+    private:
+    static constexpr std::uint32_t maxSpins = 1000;
+
+    // Moving average of the spins needed (a racy update is fine, it is only a hint)
+    void learn(std::uint32_t spun){
+        auto s = spins_.load(std::memory_order_relaxed);
+        auto updated = static_cast<std::int64_t>(s) + (static_cast<std::int64_t>(spun) - static_cast<std::int64_t>(s)) / 8;
+        spins_.store(static_cast<std::uint32_t>(updated), std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint32_t> state_{0};
+    std::atomic<std::uint32_t> spins_{0};
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Hint to the CPU that this is a spin-wait loop: on x86 "pause" saves power, lets the other
+// hyper-thread run and avoids the memory-order mis-speculation when the awaited line changes
+inline void cpuRelax(){
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+// Bounded exponential backoff with jitter for a thread waiting on a busy lock
+// Every wait() pauses a random number of times in [limit / 2, limit] and doubles limit up to maxLimit;
+// the jitter keeps the losers from retrying in lock-step, the bound keeps the handoff latency low.
+// Once the limit is saturated the thread also yields, so a preempted holder gets the CPU back
+class Backoff{
+    public:
+    explicit Backoff(std::uint32_t minLimit = 4, std::uint32_t maxLimit = 256)
+        : limit_(minLimit), max_(maxLimit){}
+
+    void wait(){
+        auto n = limit_ / 2 + next() % (limit_ / 2 + 1);
+        for(std::uint32_t i = 0; i < n; i++){
+            cpuRelax();
+        }
+        if(limit_ < max_){
+            limit_ *= 2;
+        }
+        else{
+            std::this_thread::yield();
+        }
+    }
+    void reset(std::uint32_t minLimit = 4){
+        limit_ = minLimit;
+    }
+
+    private:
+    // xorshift32, one state per thread
+    static std::uint32_t next(){
+        thread_local std::uint32_t state =
+            static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    std::uint32_t limit_;
+    std::uint32_t max_;
+};
+
+// Wait loop for a thread spinning on a line nobody else spins on (a queue lock node, a ticket):
+// pause for the first spins iterations, then yield, so a waiter whose turn comes while it is
+// descheduled (or whose predecessor is) does not hold up the others for a whole time slice
+class SpinWait{
+    public:
+    explicit SpinWait(std::uint32_t spins = 128) : spins_(spins){}
+
+    void wait(){
+        if(count_ < spins_){
+            count_++;
+            cpuRelax();
+        }
+        else{
+            std::this_thread::yield();
+        }
+    }
+
+    private:
+    std::uint32_t spins_;
+    std::uint32_t count_ = 0;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <atomic>
+#include <thread>
+
+// SpinLockAtom and SpinLockAtomFlag are two implementations of a spinlock using atomic operations.
+// SpinLockAtom uses std::atomic<bool> for locking, while SpinLockAtomFlag uses std::atomic_flag.
+class SpinLockAtom {
+    std::atomic<bool> atom{false};
+    public:
+    void lock(){
+        while(atom.exchange(true)){
+            std::this_thread::yield();
+        }
+    }
+    void unlock(){
+        atom.store(false, std::memory_order_release);
+    }
+};
+
+class SpinLockAtomFlag{
+    std::atomic_flag atom = ATOMIC_FLAG_INIT;
+    public:
+    void lock(){
+        while(atom.test_and_set(std::memory_order_acquire)){
+            std::this_thread::yield();
+        }
+    }
+    void unlock(){
+        atom.clear(std::memory_order_release);
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include "backoff.hpp"
+
+// "Big-reader" lock: a reader-writer lock whose readers do not share a cache line
+// - every thread is given one of slots reader counters (round robin, at least one per core),
+//   each counter on its own cache line; lock_shared / unlock_shared touch only the own slot
+// - a writer raises the writer flag and waits until every slot is empty
+// - a reader increments its slot and then checks the flag (both seq_cst, so the writer either sees the
+//   reader or the reader sees the writer); if a writer is there it decrements again and waits:
+//   writers get priority and readers cannot starve them
+// Writes cost O(slots), reads cost one uncontended RMW on a private line
+// Meets SharedMutex: works with std::shared_lock / std::unique_lock
+class BrLock{
+    public:
+    explicit BrLock(std::size_t slots = std::max(1u, std::thread::hardware_concurrency()))
+        : count_(std::max<std::size_t>(slots, 1)), slots_(std::make_unique<Slot[]>(count_)){}
+    BrLock(const BrLock&) = delete;
+    BrLock& operator=(const BrLock&) = delete;
+
+    void lock_shared(){
+        auto& readers = slots_[threadSlot() % count_].readers;
+        while(true){
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if(!writer_.load(std::memory_order_seq_cst)){
+                return;
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+            SpinWait spin;
+            while(writer_.load(std::memory_order_relaxed)){
+                spin.wait();
+            }
+        }
+    }
+    bool try_lock_shared(){
+        auto& readers = slots_[threadSlot() % count_].readers;
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        if(!writer_.load(std::memory_order_seq_cst)){
+            return true;
+        }
+        readers.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+    void unlock_shared(){
+        slots_[threadSlot() % count_].readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    void lock(){
+        Backoff backoff;
+        while(writer_.load(std::memory_order_relaxed) || writer_.exchange(true, std::memory_order_seq_cst)){
+            backoff.wait();
+        }
+        waitForReaders();
+    }
+    bool try_lock(){
+        if(writer_.load(std::memory_order_relaxed) || writer_.exchange(true, std::memory_order_seq_cst)){
+            return false;
+        }
+        for(std::size_t i = 0; i < count_; i++){
+            if(slots_[i].readers.load(std::memory_order_seq_cst) != 0){
+                writer_.store(false, std::memory_order_release);
+                return false;
+            }
+        }
+        return true;
+    }
+    void unlock(){
+        writer_.store(false, std::memory_order_release);
+    }
+
+    private:
+    struct alignas(64) Slot{
+        std::atomic<std::size_t> readers{0};
+    };
+
+    // Slot number of the calling thread, the same for every BrLock
+    static std::size_t threadSlot(){
+        static std::atomic<std::size_t> nextSlot{0};
+        thread_local std::size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+    void waitForReaders(){
+        for(std::size_t i = 0; i < count_; i++){
+            SpinWait spin;
+            // Pairs with the readers' increment; as an acquire it orders their critical sections before the write
+            while(slots_[i].readers.load(std::memory_order_seq_cst) != 0){
+                spin.wait();
+            }
+        }
+    }
+
+    std::size_t count_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<bool> writer_{false};
+};
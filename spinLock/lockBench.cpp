@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "adaptiveLock.hpp"
+#include "basicSpinLocks.hpp"
+#include "brLock.hpp"
+#include "histogram.hpp"
+#include "queueLocks.hpp"
+#include "ttasSpinLock.hpp"
+
+// Lock contention benchmark for any Lockable
+// Every thread loops: non-critical work, take the lock, critical section, release
+// - threads start together behind a barrier, the clock starts when it opens
+// - each run lasts a fixed time; throughput counts every acquisition
+// - acquisition latency (lock() call to return) is timed for every sample-th acquisition
+//   into a LatencyHistogram per thread
+// - fairness: standard deviation of acquisitions per thread, in % of the mean
+// - a read (--reads percent of the operations) takes lock_shared() if the lock has it, lock() otherwise
+//
+// Usage: lockBench [--threads 1,2,4,8] [--cs 10] [--work 100] [--reads 0] [--ms 200] [--sample 8]
+//                  [--locks all|mutex,ttas,...] [--format table|csv|json]
+// --cs and --work are loop iterations over a few shared / private words
+
+struct Config{
+    std::vector<std::size_t> threads{1, 2, 4, 8};
+    std::size_t cs = 10;
+    std::size_t work = 100;
+    unsigned reads = 0;
+    std::chrono::milliseconds duration{200};
+    std::size_t sample = 8;
+    std::vector<std::string> locks;
+    std::string format = "table";
+};
+
+struct Result{
+    std::string lock;
+    std::size_t threads = 0;
+    double opsPerSec = 0;
+    double meanNs = 0;
+    double p50Ns = 0;
+    double p90Ns = 0;
+    double p99Ns = 0;
+    double p999Ns = 0;
+    double maxNs = 0;
+    // Standard deviation of acquisitions per thread, % of the mean
+    double spread = 0;
+};
+
+// Data touched in the critical section, on its own cache lines
+struct alignas(64) Shared{
+    std::uint64_t words[8] = {};
+};
+
+template<typename Lock>
+Result run(const std::string& name, const Config& cfg, std::size_t threadCount){
+    Lock lock;
+    Shared shared;
+    std::atomic<bool> stop{false};
+    std::vector<std::uint64_t> acquisitions(threadCount);
+    std::vector<LatencyHistogram> latency(threadCount);
+    std::atomic<std::uint64_t> sink{0};
+    // Workers and this thread: nobody starts before every thread exists
+    std::barrier sync(static_cast<std::ptrdiff_t>(threadCount) + 1);
+    std::vector<std::jthread> pool;
+    for(std::size_t t = 0; t < threadCount; t++){
+        pool.emplace_back([&, t]{
+            std::uint32_t rng = static_cast<std::uint32_t>(t) * 2654435761u + 1;
+            std::uint64_t local = t, n = 0, seen = 0;
+            auto& hist = latency[t];
+            sync.arrive_and_wait();
+            while(!stop.load(std::memory_order_relaxed)){
+                for(std::size_t i = 0; i < cfg.work; i++){
+                    local = local * 6364136223846793005ULL + 1442695040888963407ULL;
+                }
+                rng ^= rng << 13;
+                rng ^= rng >> 17;
+                rng ^= rng << 5;
+                bool read = rng % 100 < cfg.reads;
+                bool timed = ++seen == cfg.sample;
+                std::chrono::steady_clock::time_point before, acquired;
+                if(timed){
+                    seen = 0;
+                    before = std::chrono::steady_clock::now();
+                }
+                if constexpr(requires(Lock& l){l.lock_shared();}){
+                    if(read){
+                        lock.lock_shared();
+                    }
+                    else{
+                        lock.lock();
+                    }
+                }
+                else{
+                    lock.lock();
+                }
+                if(timed){
+                    // Only the clock read while holding the lock, the histogram is updated after unlock
+                    acquired = std::chrono::steady_clock::now();
+                }
+                if(read){
+                    for(std::size_t i = 0; i < cfg.cs; i++){
+                        local += shared.words[i % 8];
+                    }
+                }
+                else{
+                    for(std::size_t i = 0; i < cfg.cs; i++){
+                        shared.words[i % 8] += local;
+                    }
+                }
+                if constexpr(requires(Lock& l){l.unlock_shared();}){
+                    if(read){
+                        lock.unlock_shared();
+                    }
+                    else{
+                        lock.unlock();
+                    }
+                }
+                else{
+                    lock.unlock();
+                }
+                if(timed){
+                    hist.record(acquired - before);
+                }
+                n++;
+            }
+            acquisitions[t] = n;
+            // Keeps the work loops from being optimized away
+            sink.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    sync.arrive_and_wait();
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_until(start + cfg.duration);
+    stop = true;
+    pool.clear();
+    auto end = std::chrono::steady_clock::now();
+
+    LatencyHistogram all;
+    double total = 0;
+    for(std::size_t t = 0; t < threadCount; t++){
+        all.merge(latency[t]);
+        total += static_cast<double>(acquisitions[t]);
+    }
+    double mean = total / static_cast<double>(threadCount);
+    double var = 0;
+    for(auto a : acquisitions){
+        var += (static_cast<double>(a) - mean) * (static_cast<double>(a) - mean);
+    }
+    Result r;
+    r.lock = name;
+    r.threads = threadCount;
+    r.opsPerSec = total / std::chrono::duration<double>(end - start).count();
+    r.meanNs = static_cast<double>(all.mean().count());
+    r.p50Ns = static_cast<double>(all.percentile(0.5).count());
+    r.p90Ns = static_cast<double>(all.percentile(0.9).count());
+    r.p99Ns = static_cast<double>(all.percentile(0.99).count());
+    r.p999Ns = static_cast<double>(all.percentile(0.999).count());
+    r.maxNs = static_cast<double>(all.max().count());
+    r.spread = mean > 0 ? 100.0 * std::sqrt(var / static_cast<double>(threadCount)) / mean : 0.0;
+    return r;
+}
+
+using Runner = std::function<Result(const Config&, std::size_t)>;
+
+template<typename Lock>
+std::pair<std::string, Runner> entry(const std::string& name){
+    return {name, [name](const Config& cfg, std::size_t threads){
+        return run<Lock>(name, cfg, threads);
+    }};
+}
+
+std::vector<std::string> split(const std::string& s){
+    std::vector<std::string> parts;
+    std::istringstream in(s);
+    std::string part;
+    while(std::getline(in, part, ',')){
+        if(!part.empty()){
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+Config parse(int argc, char* argv[]){
+    Config cfg;
+    for(int i = 1; i + 1 < argc; i += 2){
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if(key == "--threads"){
+            cfg.threads.clear();
+            for(auto& p : split(value)){
+                cfg.threads.push_back(std::max<std::size_t>(1, std::stoul(p)));
+            }
+        }
+        else if(key == "--cs"){
+            cfg.cs = std::stoul(value);
+        }
+        else if(key == "--work"){
+            cfg.work = std::stoul(value);
+        }
+        else if(key == "--reads"){
+            cfg.reads = static_cast<unsigned>(std::min(100ul, std::stoul(value)));
+        }
+        else if(key == "--ms"){
+            cfg.duration = std::chrono::milliseconds(std::stoul(value));
+        }
+        else if(key == "--sample"){
+            cfg.sample = std::max<std::size_t>(1, std::stoul(value));
+        }
+        else if(key == "--locks"){
+            cfg.locks = value == "all" ? std::vector<std::string>{} : split(value);
+        }
+        else if(key == "--format"){
+            cfg.format = value;
+        }
+        else{
+            std::cerr << "Unknown option " << key << "\n";
+        }
+    }
+    return cfg;
+}
+
+void print(const Config& cfg, const std::vector<Result>& results){
+    if(cfg.format == "csv"){
+        std::cout << "lock,threads,cs,work,reads,ops_per_sec,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,spread_pct\n";
+        for(auto& r : results){
+            std::cout << r.lock << "," << r.threads << "," << cfg.cs << "," << cfg.work << "," << cfg.reads << ","
+                      << r.opsPerSec << "," << r.meanNs << "," << r.p50Ns << "," << r.p90Ns << "," << r.p99Ns << ","
+                      << r.p999Ns << "," << r.maxNs << "," << r.spread << "\n";
+        }
+    }
+    else if(cfg.format == "json"){
+        std::cout << "[\n";
+        for(std::size_t i = 0; i < results.size(); i++){
+            auto& r = results[i];
+            std::cout << "  {\"lock\": \"" << r.lock << "\", \"threads\": " << r.threads << ", \"cs\": " << cfg.cs
+                      << ", \"work\": " << cfg.work << ", \"reads\": " << cfg.reads << ", \"ops_per_sec\": " << r.opsPerSec
+                      << ", \"mean_ns\": " << r.meanNs << ", \"p50_ns\": " << r.p50Ns << ", \"p90_ns\": " << r.p90Ns
+                      << ", \"p99_ns\": " << r.p99Ns << ", \"p999_ns\": " << r.p999Ns << ", \"max_ns\": " << r.maxNs
+                      << ", \"spread_pct\": " << r.spread << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    auto cfg = parse(argc, argv);
+    std::vector<std::pair<std::string, Runner>> registry{
+        entry<SpinLockAtom>("spinatom"),
+        entry<SpinLockAtomFlag>("spinflag"),
+        entry<TtasSpinLock>("ttas"),
+        entry<AdaptiveLock>("adaptive"),
+        entry<TicketLock>("ticket"),
+        entry<McsLock>("mcs"),
+        entry<ClhLock>("clh"),
+        entry<BrLock>("brlock"),
+        entry<std::mutex>("mutex"),
+        entry<std::shared_mutex>("shared_mutex")
+    };
+    bool table = cfg.format != "csv" && cfg.format != "json";
+    if(table){
+        std::cout << "cs " << cfg.cs << ", work " << cfg.work << ", reads " << cfg.reads << "%, "
+                  << cfg.duration.count() << " ms per run, latency of every " << cfg.sample << "th acquisition\n"
+                  << "lock | threads | Mops/s | mean ns | p50 | p90 | p99 | p99.9 | max | spread %\n";
+    }
+    std::vector<Result> results;
+    for(auto& [name, runner] : registry){
+        if(!cfg.locks.empty() && std::find(cfg.locks.begin(), cfg.locks.end(), name) == cfg.locks.end()){
+            continue;
+        }
+        for(auto threads : cfg.threads){
+            auto r = runner(cfg, threads);
+            if(table){
+                std::cout << r.lock << " | " << r.threads << " | " << r.opsPerSec / 1e6 << " | " << r.meanNs << " | "
+                          << r.p50Ns << " | " << r.p90Ns << " | " << r.p99Ns << " | " << r.p999Ns << " | " << r.maxNs
+                          << " | " << r.spread << std::endl;
+            }
+            results.push_back(r);
+        }
+    }
+    print(cfg, results);
+}
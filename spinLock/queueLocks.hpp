@@ -0,0 +1,223 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "backoff.hpp"
+
+// Fair (FIFO) spinlocks for heavy contention
+// All three have plain lock() / unlock() / try_lock(), so they are drop-in Lockable types;
+// the MCS and CLH queue nodes come from a small per-thread pool instead of the caller's stack
+
+// Ticket lock: take a number, wait until it is served
+// Waiters only read nowServing_, which lives on its own cache line, so newcomers taking a
+// ticket do not disturb them; every unlock still invalidates the line in every waiter's cache
+class TicketLock{
+    public:
+    void lock(){
+        auto ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        SpinWait spin;
+        while(nowServing_.load(std::memory_order_acquire) != ticket){
+            spin.wait();
+        }
+    }
+    bool try_lock(){
+        // Acquire: pairs with the release in unlock() if the CAS succeeds
+        auto serving = nowServing_.load(std::memory_order_acquire);
+        auto ticket = serving;
+        return next_.compare_exchange_strong(ticket, serving + 1, std::memory_order_relaxed);
+    }
+    void unlock(){
+        // Only the holder writes nowServing_
+        nowServing_.store(nowServing_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    private:
+    alignas(64) std::atomic<std::uint32_t> next_{0};
+    alignas(64) std::atomic<std::uint32_t> nowServing_{0};
+};
+
+// Free queue nodes of the calling thread, shared by all locks using Node
+// A thread leaving hands its nodes to a global spare list, new threads take them from there;
+// nodes are deleted only at program exit, so reading a node another thread has recycled
+// (ClhLock::try_lock may) is always safe
+template<typename Node>
+class NodePool{
+    public:
+    static Node* get(){
+        auto& free = pool().free;
+        if(free.empty()){
+            auto& s = spare();
+            std::lock_guard<std::mutex> lk(s.mtx);
+            if(s.nodes.empty()){
+                return new Node;
+            }
+            free.swap(s.nodes);
+        }
+        auto* node = free.back();
+        free.pop_back();
+        return node;
+    }
+    static void put(Node* node){
+        pool().free.push_back(node);
+    }
+
+    private:
+    struct Spare{
+        std::mutex mtx;
+        std::vector<Node*> nodes;
+        ~Spare(){
+            for(auto* node : nodes){
+                delete node;
+            }
+        }
+    };
+    struct Pool{
+        std::vector<Node*> free;
+        Pool(){
+            // Constructed first, destroyed after the pools of all threads
+            spare();
+        }
+        ~Pool(){
+            auto& s = spare();
+            std::lock_guard<std::mutex> lk(s.mtx);
+            s.nodes.insert(s.nodes.end(), free.begin(), free.end());
+        }
+    };
+    static Spare& spare(){
+        static Spare s;
+        return s;
+    }
+    static Pool& pool(){
+        thread_local Pool p;
+        return p;
+    }
+};
+
+// MCS lock: waiters form a linked queue, each spins on the flag of its own node
+// The holder hands the lock to its successor by clearing the successor's flag: one cache line
+// moves per handoff no matter how many threads wait
+class McsLock{
+    public:
+    void lock(){
+        auto* node = NodePool<Node>::get();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+        auto* pred = tail_.exchange(node, std::memory_order_acq_rel);
+        if(pred != nullptr){
+            pred->next.store(node, std::memory_order_release);
+            SpinWait spin;
+            while(node->locked.load(std::memory_order_acquire)){
+                spin.wait();
+            }
+        }
+        holder_ = node;
+    }
+    bool try_lock(){
+        auto* node = NodePool<Node>::get();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* expected = nullptr;
+        if(tail_.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed)){
+            holder_ = node;
+            return true;
+        }
+        NodePool<Node>::put(node);
+        return false;
+    }
+    void unlock(){
+        auto* node = holder_;
+        auto* next = node->next.load(std::memory_order_acquire);
+        if(next == nullptr){
+            // No successor visible: free the lock unless somebody is just enqueuing
+            auto* expected = node;
+            if(tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)){
+                NodePool<Node>::put(node);
+                return;
+            }
+            // The successor has swapped the tail but not linked itself yet
+            SpinWait spin;
+            while((next = node->next.load(std::memory_order_acquire)) == nullptr){
+                spin.wait();
+            }
+        }
+        next->locked.store(false, std::memory_order_release);
+        // Nobody touches node any more
+        NodePool<Node>::put(node);
+    }
+
+    private:
+    struct alignas(64) Node{
+        std::atomic<Node*> next{nullptr};
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(64) std::atomic<Node*> tail_{nullptr};
+    // Written and read by the holder only
+    Node* holder_ = nullptr;
+};
+
+// CLH lock: waiters form an implicit queue, each spins on the node of its predecessor
+// Unlock is a single store to the own node; the thread then takes the predecessor's node
+// for its next acquisition (the own node still belongs to the successor)
+class ClhLock{
+    public:
+    ClhLock() : tail_(NodePool<Node>::get()){
+        // A released node to queue behind
+        tail_.load(std::memory_order_relaxed)->locked.store(false, std::memory_order_relaxed);
+    }
+    ClhLock(const ClhLock&) = delete;
+    ClhLock& operator=(const ClhLock&) = delete;
+    ~ClhLock(){
+        // The last released node, owned by nobody else
+        NodePool<Node>::put(tail_.load(std::memory_order_relaxed));
+    }
+
+    void lock(){
+        auto* node = NodePool<Node>::get();
+        node->locked.store(true, std::memory_order_relaxed);
+        auto* pred = tail_.exchange(node, std::memory_order_acq_rel);
+        SpinWait spin;
+        while(pred->locked.load(std::memory_order_acquire)){
+            spin.wait();
+        }
+        holder_ = node;
+        holderPred_ = pred;
+    }
+    bool try_lock(){
+        auto* pred = tail_.load(std::memory_order_acquire);
+        if(pred->locked.load(std::memory_order_relaxed)){
+            return false;
+        }
+        auto* node = NodePool<Node>::get();
+        node->locked.store(true, std::memory_order_relaxed);
+        if(tail_.compare_exchange_strong(pred, node, std::memory_order_acq_rel, std::memory_order_relaxed)){
+            // Now queued behind pred: normally it is the released node seen above, but it may have been
+            // recycled and enqueued again in between (ABA), then this waits like lock()
+            SpinWait spin;
+            while(pred->locked.load(std::memory_order_acquire)){
+                spin.wait();
+            }
+            holder_ = node;
+            holderPred_ = pred;
+            return true;
+        }
+        NodePool<Node>::put(node);
+        return false;
+    }
+    void unlock(){
+        auto* pred = holderPred_;
+        holder_->locked.store(false, std::memory_order_release);
+        // Nobody spins on the predecessor's node any more
+        NodePool<Node>::put(pred);
+    }
+
+    private:
+    struct alignas(64) Node{
+        std::atomic<bool> locked{false};
+    };
+
+    alignas(64) std::atomic<Node*> tail_;
+    // Written and read by the holder only
+    Node* holder_ = nullptr;
+    Node* holderPred_ = nullptr;
+};
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "brLock.hpp"
+#include "seqLock.hpp"
+
+// Read-mostly data: std::shared_mutex vs BrLock (per-slot reader counters) vs SeqLock
+// Every thread reads or writes a four-word snapshot (90/10 and 99/1 read/write mixes) for a fixed time;
+// readers check that the snapshot is consistent
+// Usage: rwLockBench [max threads] [ms per run]
+
+struct Snapshot{
+    std::uint64_t version = 0;
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+    // a + b, lets readers detect a torn read
+    std::uint64_t sum = 0;
+};
+
+Snapshot next(const Snapshot& s){
+    return Snapshot{s.version + 1, s.a + 3, s.b + 5, s.a + 3 + s.b + 5};
+}
+
+// Reader-writer locks guarding a plain Snapshot
+template<typename Lock>
+struct Locked{
+    Lock lock;
+    Snapshot data;
+
+    Snapshot read(){
+        std::shared_lock lk(lock);
+        return data;
+    }
+    void write(){
+        std::unique_lock lk(lock);
+        data = next(data);
+    }
+};
+
+struct Seq{
+    SeqLock<Snapshot> data;
+
+    Snapshot read(){
+        return data.load();
+    }
+    void write(){
+        data.update(next);
+    }
+};
+
+// Million operations per second
+template<typename Guarded>
+double run(std::size_t threads, unsigned readPercent, std::chrono::milliseconds duration){
+    Guarded guarded;
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> ops{0};
+    std::atomic<bool> torn{false};
+    {
+        std::vector<std::jthread> pool;
+        for(std::size_t t = 0; t < threads; t++){
+            pool.emplace_back([&, t]{
+                std::uint32_t rng = static_cast<std::uint32_t>(t) * 2654435761u + 1;
+                std::uint64_t n = 0;
+                while(!stop.load(std::memory_order_relaxed)){
+                    rng ^= rng << 13;
+                    rng ^= rng >> 17;
+                    rng ^= rng << 5;
+                    if(rng % 100 < readPercent){
+                        auto s = guarded.read();
+                        if(s.a + s.b != s.sum){
+                            torn.store(true, std::memory_order_relaxed);
+                        }
+                    }
+                    else{
+                        guarded.write();
+                    }
+                    n++;
+                }
+                ops += n;
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    }
+    if(torn){
+        std::cout << "Torn read!\n";
+    }
+    return static_cast<double>(ops.load()) / (static_cast<double>(duration.count()) * 1e3);
+}
+
+int main(int argc, char* argv[]){
+    std::size_t maxThreads = std::max(2u, std::thread::hardware_concurrency());
+    std::chrono::milliseconds duration{200};
+    if(argc > 1){
+        maxThreads = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        duration = std::chrono::milliseconds(std::stoul(argv[2]));
+    }
+    for(unsigned readPercent : {90u, 99u}){
+        std::cout << readPercent << "% reads, Mops/s\n"
+                  << "threads | std::shared_mutex | BrLock | SeqLock\n";
+        for(std::size_t n = 1; n <= maxThreads; n *= 2){
+            std::cout << n << " | " << run<Locked<std::shared_mutex>>(n, readPercent, duration) << " | "
+                      << run<Locked<BrLock>>(n, readPercent, duration) << " | "
+                      << run<Seq>(n, readPercent, duration) << std::endl;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "backoff.hpp"
+
+// Sequence lock for a small trivially copyable snapshot (a few words)
+// - readers never write shared memory: they read the sequence number, copy the data and check that
+//   the sequence number has not changed (and was even, i.e. no write in progress), retrying otherwise
+// - a writer makes the sequence number odd, writes the data and makes it even again;
+//   writers are serialized by the CAS that makes the number odd
+// The data is kept in relaxed atomic words, so a reader racing with a writer reads torn but
+// well-defined values and throws them away (the fences follow Boehm, "Can seqlocks get along
+// with programming language memory models?")
+// Readers retry while writes keep coming, so it suits data written much more rarely than read
+template<typename T>
+class SeqLock{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock holds trivially copyable snapshots only");
+    static constexpr std::size_t words = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    public:
+    explicit SeqLock(const T& value = T{}){
+        write(value);
+    }
+
+    T load() const{
+        std::array<std::uint64_t, words> buf;
+        SpinWait spin;
+        while(true){
+            auto before = seq_.load(std::memory_order_acquire);
+            if(before & 1){
+                // A write is in progress (yields after a while, the writer may be preempted)
+                spin.wait();
+                continue;
+            }
+            for(std::size_t i = 0; i < words; i++){
+                buf[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(seq_.load(std::memory_order_relaxed) == before){
+                return fromWords(buf);
+            }
+        }
+    }
+
+    void store(const T& value){
+        auto seq = beginWrite();
+        write(value);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Replace the value by f(value) as one write (other writers wait, readers retry)
+    template<typename F>
+    void update(F&& f){
+        auto seq = beginWrite();
+        write(f(read()));
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Number of completed writes
+    std::uint64_t version() const{
+        return seq_.load(std::memory_order_acquire) / 2;
+    }
+
+    private:
+    // Make the sequence number odd, returns the even number it had
+    std::uint64_t beginWrite(){
+        auto seq = seq_.load(std::memory_order_relaxed);
+        SpinWait spin;
+        while(true){
+            if(seq & 1){
+                // Another writer
+                spin.wait();
+                seq = seq_.load(std::memory_order_relaxed);
+            }
+            else if(seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)){
+                break;
+            }
+        }
+        // The odd number is visible before any of the new data
+        std::atomic_thread_fence(std::memory_order_release);
+        return seq;
+    }
+    // The current value, for the writer holding the lock
+    T read() const{
+        std::array<std::uint64_t, words> buf;
+        for(std::size_t i = 0; i < words; i++){
+            buf[i] = data_[i].load(std::memory_order_relaxed);
+        }
+        return fromWords(buf);
+    }
+    // The words may be longer than T: copy its bytes out, then bit_cast (T needs no default constructor)
+    static T fromWords(const std::array<std::uint64_t, words>& buf){
+        std::array<std::byte, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), buf.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+    void write(const T& value){
+        std::array<std::uint64_t, words> buf{};
+        std::memcpy(buf.data(), &value, sizeof(T));
+        for(std::size_t i = 0; i < words; i++){
+            data_[i].store(buf[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<std::uint64_t> seq_{0};
+    std::array<std::atomic<std::uint64_t>, words> data_{};
+};
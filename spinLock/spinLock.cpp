@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <ostream>
@@ -6,38 +7,18 @@
 #include <sstream>
 #include <vector>
 #include <chrono>
-
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include "adaptiveLock.hpp"
+#include "basicSpinLocks.hpp"
+#include "queueLocks.hpp"
+#include "ttasSpinLock.hpp"
 
 int counter = 0;
 
-// SpinLockAtom and SpinLockAtomFlag are two implementations of a spinlock using atomic operations.
-// SpinLockAtom uses std::atomic<bool> for locking, while SpinLockAtomFlag uses std::atomic_flag.
-class SpinLockAtom {
-    std::atomic<bool> atom{false};
-    public:
-    void lock(){
-        while(atom.exchange(true)){
-            std::this_thread::yield();
-        }
-    }
-    void unlock(){
-        atom.store(false, std::memory_order_release);
-    }
-};
-
-class SpinLockAtomFlag{
-    std::atomic_flag atom = ATOMIC_FLAG_INIT;
-    public:
-    void lock(){
-        while(atom.test_and_set(std::memory_order_acquire)){
-            std::this_thread::yield();
-        }
-    }
-    void unlock(){
-        atom.clear(std::memory_order_release);
-    }
-};
-
 template<typename Sp>
 void increaseSpinLockAtom(Sp& sl){
     for(int i = 0; i < 10000; i++){
@@ -49,64 +30,119 @@ void increaseSpinLockAtom(Sp& sl){
     }  
 }
 
-int main(){
-    // Test the SpinLockAtom (atomic spinlock) implementation
-    {
-        SpinLockAtom sl;
-        std::vector<std::thread> threads;
-        for(int i = 0; i < 10; i++){
-            threads.emplace_back(increaseSpinLockAtom<SpinLockAtom>, std::ref(sl));
-        }
-        auto start = std::chrono::high_resolution_clock::now();
-        for(auto& t : threads){
-            t.join();
-        }
-        auto end = std::chrono::high_resolution_clock::now();
-        std::cout << "Final counter value (SpinLockAtom): " << counter <<
-                        "\nTime taken: " << end - start << std::endl;
-        
+// A critical section of a few nanoseconds
+template<typename Sp>
+void increaseShort(Sp& sl){
+    for(int i = 0; i < 100000; i++){
+        sl.lock();
+        counter++;
+        sl.unlock();
     }
+}
+
+// Run Work on threadCount threads sharing one lock of type Sp
+// CPU time is summed over all threads: spinning waiters show up there, parked ones do not
+template<typename Sp, void (*Work)(Sp&) = increaseSpinLockAtom<Sp>>
+void measure(const char* name, std::size_t threadCount){
     counter = 0;
-    // Test the SpinLockAtomFlag (atomic flag spinlock) implementation
-    {
-        SpinLockAtomFlag slf;
-        std::vector<std::thread> threads;
-        for(int i = 0; i < 10; i++){
-            threads.emplace_back(increaseSpinLockAtom<SpinLockAtomFlag>, std::ref(slf));
-        }
-        auto start = std::chrono::high_resolution_clock::now();
-        for(auto& t : threads){
-            t.join();
-        }
-        auto end = std::chrono::high_resolution_clock::now();
-        std::cout << "Final counter value (SpinLockAtomFlag): " << counter <<
-                        "\nTime taken: " << end - start << std::endl;
+    Sp sl;
+    std::vector<std::thread> threads;
+    auto cpuStart = std::clock();
+    for(std::size_t i = 0; i < threadCount; i++){
+        threads.emplace_back(Work, std::ref(sl));
     }
-    counter = 0;
-    // Test mutex 
-    {
-        std::mutex mtx;
-        std::vector<std::thread> threads;
-        for(int i = 0; i < 10; i++){
-            threads.emplace_back(increaseSpinLockAtom<std::mutex>, std::ref(mtx));
-        }
-        auto start = std::chrono::high_resolution_clock::now();
-        for(auto& t : threads){
-            t.join();
-        }
-        auto end = std::chrono::high_resolution_clock::now();
-        std::cout << "Final counter value (std::mutex): " << counter <<
-                        "\nTime taken: " << end - start << std::endl;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(auto& t : threads){
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto cpuMs = 1000.0 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    std::cout << name << " | " << threadCount << " | " << counter << " | "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " | " << cpuMs << std::endl;
+}
+
+// threadCount threads take the lock for a short critical section until the time is up
+// Prints the throughput and the spread of acquisitions per thread (0 for a perfectly fair lock)
+template<typename Sp>
+void fairness(const char* name, std::size_t threadCount, std::chrono::milliseconds duration){
+    Sp sl;
+    std::atomic<bool> stop{false};
+    std::vector<std::uint64_t> acquisitions(threadCount);
+    std::vector<std::thread> threads;
+    for(std::size_t i = 0; i < threadCount; i++){
+        threads.emplace_back([&, i]{
+            std::uint64_t n = 0;
+            while(!stop.load(std::memory_order_relaxed)){
+                sl.lock();
+                counter++;
+                sl.unlock();
+                n++;
+            }
+            acquisitions[i] = n;
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for(auto& t : threads){
+        t.join();
+    }
+    double total = 0;
+    for(auto n : acquisitions){
+        total += static_cast<double>(n);
+    }
+    double mean = total / static_cast<double>(threadCount);
+    double var = 0;
+    for(auto n : acquisitions){
+        var += (static_cast<double>(n) - mean) * (static_cast<double>(n) - mean);
+    }
+    double stddev = std::sqrt(var / static_cast<double>(threadCount));
+    std::cout << name << " | " << threadCount << " | " << total / (duration.count() * 1e3) << " | " << mean << " | "
+              << stddev << " | " << (mean > 0 ? 100.0 * stddev / mean : 0.0) << std::endl;
+}
+
+// Usage: spinLock [max threads]
+int main(int argc, char* argv[]){
+    std::size_t maxThreads = 64;
+    if(argc > 1){
+        maxThreads = std::stoul(argv[1]);
+    }
+    std::cout << "lock | threads | final counter | time, ms | CPU time, ms\n";
+    for(std::size_t n = 2; n <= maxThreads; n *= 2){
+        // SpinLockAtom: exchange(true) in a loop with yield()
+        measure<SpinLockAtom>("SpinLockAtom", n);
+        // SpinLockAtomFlag: test_and_set in a loop with yield()
+        measure<SpinLockAtomFlag>("SpinLockAtomFlag", n);
+        // TtasSpinLock: relaxed read spin, pause, exponential backoff with jitter
+        measure<TtasSpinLock>("TtasSpinLock", n);
+        // AdaptiveLock: learned spin, then std::atomic::wait
+        measure<AdaptiveLock>("AdaptiveLock", n);
+        // FIFO locks: ticket, MCS and CLH queues
+        measure<TicketLock>("TicketLock", n);
+        measure<McsLock>("McsLock", n);
+        measure<ClhLock>("ClhLock", n);
+        measure<std::mutex>("std::mutex", n);
     }
 
+    // Few-nanosecond critical sections with fewer threads than cores and with four times more
+    std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\nShort critical section, " << cores << " cores\n"
+              << "lock | threads | final counter | time, ms | CPU time, ms\n";
+    for(std::size_t n : {std::max<std::size_t>(1, cores / 2), cores * 4}){
+        measure<TtasSpinLock, increaseShort<TtasSpinLock>>("TtasSpinLock", n);
+        measure<AdaptiveLock, increaseShort<AdaptiveLock>>("AdaptiveLock", n);
+        measure<std::mutex, increaseShort<std::mutex>>("std::mutex", n);
+    }
+
+    // Fairness at high thread counts: acquisitions per thread in a fixed time
+    std::cout << "\nFairness, 200 ms per run\n"
+              << "lock | threads | Mops/s | mean acquisitions | stddev | stddev, % of mean\n";
+    for(std::size_t n : {std::max<std::size_t>(maxThreads / 4, 2), maxThreads}){
+        constexpr std::chrono::milliseconds duration{200};
+        fairness<SpinLockAtom>("SpinLockAtom", n, duration);
+        fairness<TtasSpinLock>("TtasSpinLock", n, duration);
+        fairness<TicketLock>("TicketLock", n, duration);
+        fairness<McsLock>("McsLock", n, duration);
+        fairness<ClhLock>("ClhLock", n, duration);
+        fairness<std::mutex>("std::mutex", n, duration);
+    }
 }
-/*
-Example output:
-Final counter value (SpinLockAtom): 100000
-Time taken: 251412300ns
-Final counter value (SpinLockAtomFlag): 100000
-Time taken: 250926400ns
-Final counter value (std::mutex): 100000
-Time taken: 593666200ns
-This output shows that both SpinLockAtom and SpinLockAtomFlag perform similarly, while std::mutex is slower in this case.
-*/
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include "backoff.hpp"
+
+// Test-and-test-and-set spinlock
+// - waiters spin on a relaxed load, so the cache line stays shared in every waiter's cache
+//   and is not bounced around by writes (exchange always writes, even when it fails)
+// - the exchange is tried only when the lock looks free; between looks the waiter pauses
+//   for an exponentially growing, jittered number of cycles (and yields once that is saturated)
+// - acquire / release ordering instead of seq_cst
+class TtasSpinLock{
+    std::atomic<bool> locked_{false};
+    public:
+    void lock(){
+        // Uncontended: one exchange
+        if(!locked_.exchange(true, std::memory_order_acquire)){
+            return;
+        }
+        Backoff backoff;
+        while(true){
+            // Read-only spin, a little longer after every look or lost race
+            while(locked_.load(std::memory_order_relaxed)){
+                backoff.wait();
+            }
+            if(!locked_.exchange(true, std::memory_order_acquire)){
+                return;
+            }
+        }
+    }
+    bool try_lock(){
+        // Do not write the line if the lock is taken
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+    void unlock(){
+        locked_.store(false, std::memory_order_release);
+    }
+};
@@ -0,0 +1,386 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// C++20 coroutines on top of the thread pool
+// task<T>     - lazy coroutine, starts when it is awaited and resumes the awaiting coroutine when done
+// when_all    - await several tasks started at once
+// sync_wait   - block a normal thread until a task is finished
+// Moving a coroutine to a worker is done with co_await pool.schedule() (see ThreadPool_jthread)
+
+template<typename T = void>
+class task;
+
+namespace detail{
+
+// void results are stored as std::monostate
+template<typename T>
+using NonVoid = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+struct TaskPromiseBase{
+    // Coroutine waiting for this one, resumed by final_suspend
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    // Symmetric transfer to the continuation, so long chains do not grow the stack
+    struct FinalAwaiter{
+        bool await_ready() const noexcept{
+            return false;
+        }
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept{
+            return h.promise().continuation;
+        }
+        void await_resume() const noexcept{}
+    };
+
+    std::suspend_always initial_suspend() const noexcept{
+        return {};
+    }
+    FinalAwaiter final_suspend() const noexcept{
+        return {};
+    }
+    void unhandled_exception() noexcept{
+        error = std::current_exception();
+    }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase{
+    std::optional<T> value;
+
+    task<T> get_return_object() noexcept;
+    template<typename U>
+    void return_value(U&& v){
+        value.emplace(std::forward<U>(v));
+    }
+    T result(){
+        if(error){
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase{
+    task<void> get_return_object() noexcept;
+    void return_void() const noexcept{}
+    void result(){
+        if(error){
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+class task{
+    public:
+    using promise_type = detail::TaskPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    task() noexcept = default;
+    explicit task(handle_type h) noexcept : h_(h){}
+    task(task&& other) noexcept : h_(std::exchange(other.h_, nullptr)){}
+    task& operator=(task&& other) noexcept{
+        if(this != &other){
+            if(h_){
+                h_.destroy();
+            }
+            h_ = std::exchange(other.h_, nullptr);
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task(){
+        if(h_){
+            h_.destroy();
+        }
+    }
+
+    // Start the task and suspend the awaiting coroutine until the task is finished
+    auto operator co_await() noexcept{
+        struct Awaiter{
+            handle_type h;
+            bool await_ready() const noexcept{
+                return h.done();
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept{
+                h.promise().continuation = awaiting;
+                return h;
+            }
+            T await_resume(){
+                return h.promise().result();
+            }
+        };
+        return Awaiter{h_};
+    }
+
+    private:
+    handle_type h_ = nullptr;
+};
+
+namespace detail{
+
+template<typename T>
+task<T> TaskPromise<T>::get_return_object() noexcept{
+    return task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline task<void> TaskPromise<void>::get_return_object() noexcept{
+    return task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Counter of unfinished children of when_all
+// The parent holds one extra count while it starts the children
+struct WhenAllCounter{
+    std::atomic<std::size_t> count;
+    std::coroutine_handle<> parent;
+};
+
+// Coroutine driving one child of when_all, reports to the counter when finished
+struct WhenAllChild{
+    struct promise_type{
+        WhenAllCounter* counter = nullptr;
+
+        struct FinalAwaiter{
+            bool await_ready() const noexcept{
+                return false;
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept{
+                auto* counter = h.promise().counter;
+                if(counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                    return counter->parent;
+                }
+                return std::noop_coroutine();
+            }
+            void await_resume() const noexcept{}
+        };
+
+        WhenAllChild get_return_object() noexcept{
+            return WhenAllChild{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept{
+            return {};
+        }
+        FinalAwaiter final_suspend() const noexcept{
+            return {};
+        }
+        void return_void() const noexcept{}
+        // Exceptions of the child are caught in runChild
+        void unhandled_exception() const noexcept{
+            std::terminate();
+        }
+    };
+
+    explicit WhenAllChild(std::coroutine_handle<promise_type> h) noexcept : h(h){}
+    WhenAllChild(WhenAllChild&& other) noexcept : h(std::exchange(other.h, nullptr)){}
+    WhenAllChild(const WhenAllChild&) = delete;
+    ~WhenAllChild(){
+        if(h){
+            h.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> h;
+};
+
+template<typename T>
+WhenAllChild runChild(task<T>& t, std::optional<NonVoid<T>>& slot, std::exception_ptr& error){
+    try{
+        if constexpr(std::is_void_v<T>){
+            co_await t;
+            slot.emplace();
+        }
+        else{
+            slot.emplace(co_await t);
+        }
+    }
+    catch(...){
+        error = std::current_exception();
+    }
+}
+
+// Start all children and resume the parent when the last of them is finished
+struct WhenAllAwaiter{
+    std::vector<WhenAllChild>& children;
+    WhenAllCounter counter{};
+
+    bool await_ready() const noexcept{
+        return children.empty();
+    }
+    bool await_suspend(std::coroutine_handle<> parent){
+        counter.count.store(children.size() + 1, std::memory_order_relaxed);
+        counter.parent = parent;
+        for(auto& c : children){
+            c.h.promise().counter = &counter;
+            c.h.resume();
+        }
+        // Stay suspended unless all children are already finished
+        return counter.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept{}
+};
+
+inline void rethrowFirst(const std::vector<std::exception_ptr>& errors){
+    for(auto& e : errors){
+        if(e){
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+template<typename ...Ts, std::size_t ...I>
+task<std::tuple<NonVoid<Ts>...>> whenAllTuple(std::index_sequence<I...>, task<Ts>... tasks){
+    std::tuple<std::optional<NonVoid<Ts>>...> results;
+    std::vector<std::exception_ptr> errors(sizeof...(Ts));
+    std::vector<WhenAllChild> children;
+    children.reserve(sizeof...(Ts));
+    (children.push_back(runChild(tasks, std::get<I>(results), errors[I])), ...);
+    co_await WhenAllAwaiter{children};
+    rethrowFirst(errors);
+    co_return std::tuple<NonVoid<Ts>...>(std::move(*std::get<I>(results))...);
+}
+
+} // namespace detail
+
+// Run all tasks concurrently and return their results in the same order
+// The first exception (in argument order) is rethrown after all tasks are finished
+template<typename T>
+task<std::vector<T>> when_all(std::vector<task<T>> tasks){
+    std::vector<std::optional<T>> results(tasks.size());
+    std::vector<std::exception_ptr> errors(tasks.size());
+    std::vector<detail::WhenAllChild> children;
+    children.reserve(tasks.size());
+    for(std::size_t i = 0; i < tasks.size(); i++){
+        children.push_back(detail::runChild(tasks[i], results[i], errors[i]));
+    }
+    co_await detail::WhenAllAwaiter{children};
+    detail::rethrowFirst(errors);
+    std::vector<T> res;
+    res.reserve(results.size());
+    for(auto& r : results){
+        res.push_back(std::move(*r));
+    }
+    co_return res;
+}
+
+inline task<void> when_all(std::vector<task<void>> tasks){
+    std::vector<std::optional<std::monostate>> results(tasks.size());
+    std::vector<std::exception_ptr> errors(tasks.size());
+    std::vector<detail::WhenAllChild> children;
+    children.reserve(tasks.size());
+    for(std::size_t i = 0; i < tasks.size(); i++){
+        children.push_back(detail::runChild(tasks[i], results[i], errors[i]));
+    }
+    co_await detail::WhenAllAwaiter{children};
+    detail::rethrowFirst(errors);
+}
+
+// Results of void tasks are std::monostate
+template<typename ...Ts>
+task<std::tuple<detail::NonVoid<Ts>...>> when_all(task<Ts>... tasks){
+    return detail::whenAllTuple(std::index_sequence_for<Ts...>{}, std::move(tasks)...);
+}
+
+namespace detail{
+
+// Signal for sync_wait, guarded by a mutex,
+// so the waiting thread can not destroy it while the coroutine still notifies
+struct SyncWaitEvent{
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+struct SyncWaitTask{
+    struct promise_type{
+        SyncWaitEvent* event = nullptr;
+
+        struct FinalAwaiter{
+            bool await_ready() const noexcept{
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<promise_type> h) const noexcept{
+                auto* event = h.promise().event;
+                std::lock_guard<std::mutex> lk(event->mtx);
+                event->done = true;
+                event->cv.notify_all();
+            }
+            void await_resume() const noexcept{}
+        };
+
+        SyncWaitTask get_return_object() noexcept{
+            return SyncWaitTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept{
+            return {};
+        }
+        FinalAwaiter final_suspend() const noexcept{
+            return {};
+        }
+        void return_void() const noexcept{}
+        void unhandled_exception() const noexcept{
+            std::terminate();
+        }
+    };
+
+    ~SyncWaitTask(){
+        h.destroy();
+    }
+
+    std::coroutine_handle<promise_type> h;
+};
+
+template<typename T>
+SyncWaitTask syncWaitRun(task<T>& t, std::optional<NonVoid<T>>& slot, std::exception_ptr& error){
+    try{
+        if constexpr(std::is_void_v<T>){
+            co_await t;
+            slot.emplace();
+        }
+        else{
+            slot.emplace(co_await t);
+        }
+    }
+    catch(...){
+        error = std::current_exception();
+    }
+}
+
+} // namespace detail
+
+// Start the task and block the calling thread until it is finished
+// Must not be called from a worker of the pool the task is waiting for
+template<typename T>
+T sync_wait(task<T> t){
+    std::optional<detail::NonVoid<T>> slot;
+    std::exception_ptr error;
+    detail::SyncWaitEvent event;
+    auto runner = detail::syncWaitRun(t, slot, error);
+    runner.h.promise().event = &event;
+    runner.h.resume();
+    {
+        std::unique_lock<std::mutex> lk(event.mtx);
+        event.cv.wait(lk, [&event]{return event.done;});
+    }
+    if(error){
+        std::rethrow_exception(error);
+    }
+    if constexpr(!std::is_void_v<T>){
+        return std::move(*slot);
+    }
+}
@@ -0,0 +1,150 @@
+#include "coroTask.hpp"
+#include "threadPool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Coroutine versions of the threadPool.cpp demo and of the async Fibonacci runs
+// For every run: wall-clock time, OS threads created for the run and context switches of the process
+// Usage: coroutines [n] [cutoff]
+
+// Number of threads created by std::async in the current run
+std::atomic<int> asyncThreads{0};
+
+// Voluntary + involuntary context switches of the whole process (-1 if not available)
+long contextSwitches(){
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+#else
+    return -1;
+#endif
+}
+
+// Print time, threads and context switches of f
+template<typename F>
+void measure(const std::string& name, int threads, F&& f){
+    asyncThreads = 0;
+    auto switches = contextSwitches();
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> ms = end - start;
+    std::cout << name << ": " << ms.count() << " ms, threads = " << threads + asyncThreads
+              << ", context switches = " << contextSwitches() - switches << std::endl;
+}
+
+// Recursive Fibonacci function
+uint64_t fibonacciRec(int n){
+    if(n <= 1){
+        return n;
+    }
+    return fibonacciRec(n - 1) + fibonacciRec(n - 2);
+}
+
+// Parallel recursion with std::async: every call above cutoff parks a thread on future.get()
+uint64_t fibonacciAsync(int n, int cutoff){
+    if(n < cutoff){
+        return fibonacciRec(n);
+    }
+    asyncThreads++;
+    auto a = std::async(std::launch::async, fibonacciAsync, n - 1, cutoff);
+    auto b = fibonacciAsync(n - 2, cutoff);
+    return a.get() + b;
+}
+
+// Parallel recursion with coroutines: a call waiting for its children is suspended, not a parked thread
+task<uint64_t> fibonacciCoro(ThreadPool_jthread& pool, int n, int cutoff){
+    co_await pool.schedule();
+    if(n < cutoff){
+        co_return fibonacciRec(n);
+    }
+    auto [a, b] = co_await when_all(fibonacciCoro(pool, n - 1, cutoff), fibonacciCoro(pool, n - 2, cutoff));
+    co_return a + b;
+}
+
+// Move a single Fibonacci computation to the pool
+task<uint64_t> fibonacciOnPool(ThreadPool_jthread& pool, int n){
+    co_await pool.schedule();
+    co_return fibonacciRec(n);
+}
+
+// Task of the threadPool.cpp demo as a coroutine
+task<int> demoTask(ThreadPool_jthread& pool, int i, std::mutex& coutMtx){
+    co_await pool.schedule();
+    // Simulate work
+    std::this_thread::sleep_for(std::chrono::milliseconds(100 * (i % 3 + 1)));
+
+    // Locate output in one string
+    std::ostringstream ss;
+    ss << "Task " << i
+       << " executed in thread " << std::this_thread::get_id()
+       << "\n";
+
+    // Safety print
+    {
+        std::lock_guard lk(coutMtx);
+        std::cout << ss.str();
+    }
+    co_return i * i;
+}
+
+int main(int argc, char* argv[]){
+    int n = 40;
+    int cutoff = 30;
+    if(argc > 1){
+        n = std::stoi(argv[1]);
+    }
+    if(argc > 2){
+        cutoff = std::stoi(argv[2]);
+    }
+    constexpr int workers = 4;
+    ThreadPool_jthread pool(workers, ThreadPool_jthread::Mode::WorkStealing);
+
+    // threadPool.cpp demo: 8 tasks on 4 workers, results collected with when_all
+    measure("Coroutine threadPool demo", workers, [&]{
+        std::mutex coutMtx;
+        std::vector<task<int>> tasks;
+        for(int i = 0; i < 8; i++){
+            tasks.push_back(demoTask(pool, i, coutMtx));
+        }
+        for(auto val : sync_wait(when_all(std::move(tasks)))){
+            std::cout << "Result: " << val << "\n";
+        }
+    });
+
+    // asyncFibonacci.cpp: three independent computations
+    measure("async fibonacciRec " + std::to_string(n) + ".." + std::to_string(n + 2), 0, [&]{
+        auto f1 = std::async(std::launch::async, fibonacciRec, n);
+        auto f2 = std::async(std::launch::async, fibonacciRec, n + 1);
+        auto f3 = std::async(std::launch::async, fibonacciRec, n + 2);
+        asyncThreads += 3;
+        f1.get();
+        f2.get();
+        f3.get();
+    });
+    measure("coroutine fibonacciRec " + std::to_string(n) + ".." + std::to_string(n + 2), workers, [&]{
+        sync_wait(when_all(fibonacciOnPool(pool, n), fibonacciOnPool(pool, n + 1), fibonacciOnPool(pool, n + 2)));
+    });
+
+    // Parallel recursion: every call waits for its two halves
+    uint64_t resAsync = 0, resCoro = 0;
+    measure("async recursive fibonacci " + std::to_string(n) + " (cutoff " + std::to_string(cutoff) + ")", 0, [&]{
+        resAsync = fibonacciAsync(n, cutoff);
+    });
+    measure("coroutine recursive fibonacci " + std::to_string(n) + " (cutoff " + std::to_string(cutoff) + ")", workers, [&]{
+        resCoro = sync_wait(fibonacciCoro(pool, n, cutoff));
+    });
+    std::cout << "Results: " << resAsync << " " << resCoro << std::endl;
+}
@@ -0,0 +1,102 @@
+#include "threadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bursty load on fixed-size pools and on an elastic pool
+// A burst is a batch of tasks blocking for a while (like I/O), bursts are separated by idle gaps
+// Reported: enqueue-to-start latency of the tasks and the number of resident worker threads
+// Usage: elasticBench [min workers] [max workers] [bursts] [tasks per burst]
+
+using Clock = std::chrono::steady_clock;
+using Mode = ThreadPool_jthread::Mode;
+
+std::chrono::nanoseconds percentile(std::vector<std::chrono::nanoseconds> v, double q){
+    std::sort(v.begin(), v.end());
+    return v[static_cast<std::size_t>(q * (v.size() - 1))];
+}
+
+void run(const std::string& name, ThreadPool_jthread& pool, std::size_t bursts, std::size_t tasks){
+    constexpr auto taskTime = std::chrono::microseconds(500);
+    constexpr auto gap = std::chrono::milliseconds(200);
+    std::vector<std::chrono::nanoseconds> latency(bursts * tasks);
+
+    // Sample the number of workers every millisecond
+    std::atomic<bool> done{false};
+    std::size_t samples = 0, sum = 0, peak = 0;
+    std::thread sampler([&]{
+        while(!done.load()){
+            auto n = pool.size();
+            samples++;
+            sum += n;
+            peak = std::max(peak, n);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    auto start = Clock::now();
+    for(std::size_t b = 0; b < bursts; b++){
+        std::vector<TaskFuture<void>> futures;
+        for(std::size_t i = 0; i < tasks; i++){
+            auto submitted = Clock::now();
+            auto& slot = latency[b * tasks + i];
+            futures.push_back(pool.enqueue([&slot, submitted, taskTime]{
+                slot = Clock::now() - submitted;
+                std::this_thread::sleep_for(taskTime);
+            }));
+        }
+        for(auto& f : futures){
+            f.get();
+        }
+        std::this_thread::sleep_for(gap);
+    }
+    std::chrono::duration<double, std::milli> total = Clock::now() - start;
+    done = true;
+    sampler.join();
+
+    std::cout << name << ": p50 = " << percentile(latency, 0.5).count() / 1000 << " us"
+              << ", p99 = " << percentile(latency, 0.99).count() / 1000 << " us"
+              << ", max = " << percentile(latency, 1.0).count() / 1000 << " us"
+              << ", threads avg = " << static_cast<double>(sum) / static_cast<double>(std::max<std::size_t>(samples, 1))
+              << ", peak = " << peak
+              << ", total = " << total.count() << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t minWorkers = 2, maxWorkers = 32, bursts = 10, tasks = 400;
+    if(argc > 1){
+        minWorkers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        maxWorkers = std::stoul(argv[2]);
+    }
+    if(argc > 3){
+        bursts = std::stoul(argv[3]);
+    }
+    if(argc > 4){
+        tasks = std::stoul(argv[4]);
+    }
+    std::cout << bursts << " bursts of " << tasks << " tasks (500 us blocking each), 200 ms gaps\n";
+    {
+        ThreadPool_jthread pool(minWorkers, Mode::WorkStealing);
+        run("Fixed " + std::to_string(minWorkers) + "       ", pool, bursts, tasks);
+    }
+    {
+        ThreadPool_jthread pool(maxWorkers, Mode::WorkStealing);
+        run("Fixed " + std::to_string(maxWorkers) + "      ", pool, bursts, tasks);
+    }
+    {
+        ThreadPool_jthread::Elastic elastic;
+        elastic.minWorkers = minWorkers;
+        elastic.maxWorkers = maxWorkers;
+        elastic.growAfter = std::chrono::milliseconds(1);
+        elastic.idleTimeout = std::chrono::milliseconds(50);
+        ThreadPool_jthread pool(elastic, Mode::WorkStealing);
+        run("Elastic " + std::to_string(minWorkers) + ".." + std::to_string(maxWorkers), pool, bursts, tasks);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear histogram of durations in nanoseconds
+// Every power of two is split into 8 buckets, so a percentile is off by at most 12.5%
+// record() is meant for one writer at a time (a worker or the owner of a lock),
+// counters are atomic, so other threads may read percentiles while it is written
+class LatencyHistogram{
+    public:
+    static constexpr std::size_t subBuckets = 8;
+    static constexpr std::size_t bucketCount = (64 - 2) * subBuckets;
+
+    void record(std::chrono::nanoseconds d){
+        auto v = static_cast<std::uint64_t>(d.count() < 0 ? 0 : d.count());
+        bump(buckets_[indexOf(v)], 1);
+        bump(count_, 1);
+        bump(sum_, v);
+        if(v > max_.load(std::memory_order_relaxed)){
+            max_.store(v, std::memory_order_relaxed);
+        }
+    }
+
+    // Add counters of other histogram (for aggregation of per-thread histograms)
+    void merge(const LatencyHistogram& other){
+        for(std::size_t i = 0; i < bucketCount; i++){
+            bump(buckets_[i], other.buckets_[i].load(std::memory_order_relaxed));
+        }
+        bump(count_, other.count_.load(std::memory_order_relaxed));
+        bump(sum_, other.sum_.load(std::memory_order_relaxed));
+        auto m = other.max_.load(std::memory_order_relaxed);
+        if(m > max_.load(std::memory_order_relaxed)){
+            max_.store(m, std::memory_order_relaxed);
+        }
+    }
+
+    void reset(){
+        for(auto& b : buckets_){
+            b.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const{
+        return count_.load(std::memory_order_relaxed);
+    }
+    std::chrono::nanoseconds mean() const{
+        auto c = count();
+        return std::chrono::nanoseconds(c == 0 ? 0 : sum_.load(std::memory_order_relaxed) / c);
+    }
+    std::chrono::nanoseconds max() const{
+        return std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+    }
+    // Upper bound of the bucket holding the q-quantile, q in [0, 1]
+    std::chrono::nanoseconds percentile(double q) const{
+        auto c = count();
+        if(c == 0){
+            return std::chrono::nanoseconds(0);
+        }
+        auto rank = static_cast<std::uint64_t>(q * static_cast<double>(c - 1)) + 1;
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < bucketCount; i++){
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if(seen >= rank){
+                auto upper = upperBound(i);
+                return std::chrono::nanoseconds(upper < max_.load(std::memory_order_relaxed) ? upper : max_.load(std::memory_order_relaxed));
+            }
+        }
+        return max();
+    }
+
+    private:
+    // Increment by single writer: plain load and store, no locked instruction
+    static void bump(std::atomic<std::uint64_t>& c, std::uint64_t v){
+        c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+    static std::size_t indexOf(std::uint64_t v){
+        if(v < subBuckets){
+            return static_cast<std::size_t>(v);
+        }
+        std::size_t octave = std::bit_width(v) - 1;
+        std::size_t sub = static_cast<std::size_t>(v >> (octave - 3)) & (subBuckets - 1);
+        return (octave - 2) * subBuckets + sub;
+    }
+    static std::uint64_t upperBound(std::size_t index){
+        if(index < subBuckets){
+            return index;
+        }
+        std::size_t octave = index / subBuckets + 2;
+        std::uint64_t sub = index % subBuckets;
+        return ((subBuckets + sub + 1) << (octave - 3)) - 1;
+    }
+
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
@@ -0,0 +1,281 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "histogram.hpp"
+#include "priorityQueue.hpp"
+#include "task.hpp"
+
+// Instrumentation of ThreadPool_jthread
+// Enabled by defining THREADPOOL_METRICS (the same way in every translation unit of the program),
+// otherwise PoolMetrics is an empty class and every hook is an empty inline function
+// Every worker writes only its own cache-line aligned slot, a snapshot sums the slots on demand
+
+#if defined(THREADPOOL_METRICS)
+inline constexpr bool poolMetricsEnabled = true;
+#else
+inline constexpr bool poolMetricsEnabled = false;
+#endif
+
+// Counters of one worker
+struct WorkerStats{
+    std::uint64_t tasks = 0;
+    // Tasks taken from deques or queues of other workers / nodes
+    std::uint64_t steals = 0;
+    // Times the worker went to sleep on a condition variable
+    std::uint64_t sleeps = 0;
+    // Time spent running tasks
+    std::chrono::nanoseconds busy{0};
+    // Time spent looking for a task in the queues (spinning over the queues, waiting for locks)
+    std::chrono::nanoseconds search{0};
+    // Time spent sleeping on a condition variable
+    std::chrono::nanoseconds sleep{0};
+
+    WorkerStats& operator+=(const WorkerStats& o){
+        tasks += o.tasks;
+        steals += o.steals;
+        sleeps += o.sleeps;
+        busy += o.busy;
+        search += o.search;
+        sleep += o.sleep;
+        return *this;
+    }
+};
+
+// State of the pool at one moment
+struct PoolMetricsSnapshot{
+    // False if the pool was compiled without THREADPOOL_METRICS, all other fields are empty then
+    bool enabled = false;
+    std::vector<WorkerStats> workers;
+    // Sum over all workers
+    WorkerStats total;
+    // Tasks run by runPendingTask() (callers of parallel_for, TaskGraph::run, ...), not part of total
+    std::uint64_t helped = 0;
+    // Queued tasks now and the maximum seen at enqueue time
+    std::size_t queueDepth = 0;
+    std::size_t maxQueueDepth = 0;
+    // Enqueue-to-start latency and run time of tasks executed by workers
+    WaitStats wait{};
+    WaitStats run{};
+
+    std::string text() const{
+        std::ostringstream ss;
+        if(!enabled){
+            ss << "metrics disabled (build with THREADPOOL_METRICS)\n";
+            return ss.str();
+        }
+        ss << "tasks " << total.tasks << " (steals " << total.steals << ", helped " << helped << ")"
+           << ", queue depth " << queueDepth << " (max " << maxQueueDepth << ")\n";
+        printStats(ss, "wait", wait);
+        printStats(ss, "run ", run);
+        ss << "busy " << ms(total.busy) << " ms, search " << ms(total.search) << " ms, sleep "
+           << ms(total.sleep) << " ms (" << total.sleeps << " sleeps)\n";
+        for(std::size_t i = 0; i < workers.size(); i++){
+            auto& w = workers[i];
+            ss << "  worker " << i << ": tasks " << w.tasks << ", steals " << w.steals
+               << ", busy " << ms(w.busy) << " ms, search " << ms(w.search) << " ms, sleep " << ms(w.sleep)
+               << " ms (" << w.sleeps << " sleeps)\n";
+        }
+        return ss.str();
+    }
+
+    // Durations are in nanoseconds
+    std::string json() const{
+        std::ostringstream ss;
+        ss << "{\"enabled\":" << (enabled ? "true" : "false")
+           << ",\"tasks\":" << total.tasks << ",\"steals\":" << total.steals << ",\"helped\":" << helped
+           << ",\"queueDepth\":" << queueDepth << ",\"maxQueueDepth\":" << maxQueueDepth
+           << ",\"wait\":" << statsJson(wait) << ",\"run\":" << statsJson(run)
+           << ",\"total\":" << workerJson(total) << ",\"workers\":[";
+        for(std::size_t i = 0; i < workers.size(); i++){
+            ss << (i > 0 ? "," : "") << workerJson(workers[i]);
+        }
+        ss << "]}";
+        return ss.str();
+    }
+
+    private:
+    static double ms(std::chrono::nanoseconds d){
+        return static_cast<double>(d.count()) / 1e6;
+    }
+    static double us(std::chrono::nanoseconds d){
+        return static_cast<double>(d.count()) / 1e3;
+    }
+    static void printStats(std::ostringstream& ss, const char* name, const WaitStats& s){
+        ss << name << " us: mean " << us(s.mean) << ", p50 " << us(s.p50) << ", p99 " << us(s.p99)
+           << ", max " << us(s.max) << "\n";
+    }
+    static std::string statsJson(const WaitStats& s){
+        std::ostringstream ss;
+        ss << "{\"count\":" << s.count << ",\"mean\":" << s.mean.count() << ",\"p50\":" << s.p50.count()
+           << ",\"p99\":" << s.p99.count() << ",\"max\":" << s.max.count() << "}";
+        return ss.str();
+    }
+    static std::string workerJson(const WorkerStats& w){
+        std::ostringstream ss;
+        ss << "{\"tasks\":" << w.tasks << ",\"steals\":" << w.steals << ",\"sleeps\":" << w.sleeps
+           << ",\"busy\":" << w.busy.count() << ",\"search\":" << w.search.count()
+           << ",\"sleep\":" << w.sleep.count() << "}";
+        return ss.str();
+    }
+};
+
+#if defined(THREADPOOL_METRICS)
+
+// Hooks called by the pool
+// Hooks taking a worker index must be called only by that worker
+class PoolMetrics{
+    public:
+    using Clock = std::chrono::steady_clock;
+    using Stamp = Clock::time_point;
+
+    explicit PoolMetrics(std::size_t workers) : slots_(workers){}
+
+    static Stamp now(){
+        return Clock::now();
+    }
+
+    // Task is about to be queued
+    void queued(Task& task){
+        task.stamp(now());
+    }
+    // Number of queued tasks after a push
+    void depth(std::size_t n){
+        auto m = maxDepth_.load(std::memory_order_relaxed);
+        while(n > m && !maxDepth_.compare_exchange_weak(m, n, std::memory_order_relaxed)){
+        }
+    }
+    // Worker found a task after searching since searchFrom, returns the start time of the task
+    Stamp started(std::size_t w, const Task& task, Stamp searchFrom){
+        auto t = now();
+        auto& s = slots_[w];
+        add(s.searchNs, t - searchFrom);
+        if(task.queuedAt() != Stamp{}){
+            s.wait.record(t - task.queuedAt());
+        }
+        return t;
+    }
+    // Worker finished the task started at start, returns the time it starts searching again
+    Stamp finished(std::size_t w, Stamp start){
+        auto t = now();
+        auto& s = slots_[w];
+        s.run.record(t - start);
+        add(s.busyNs, t - start);
+        bump(s.tasks, 1);
+        return t;
+    }
+    void stolen(std::size_t w){
+        bump(slots_[w].steals, 1);
+    }
+    // Worker goes to sleep after searching since searchFrom, returns the time it falls asleep
+    Stamp sleeping(std::size_t w, Stamp searchFrom){
+        auto t = now();
+        add(slots_[w].searchNs, t - searchFrom);
+        return t;
+    }
+    // Worker woke up, returns the time it starts searching
+    Stamp woke(std::size_t w, Stamp sleepFrom){
+        auto t = now();
+        auto& s = slots_[w];
+        add(s.sleepNs, t - sleepFrom);
+        bump(s.sleeps, 1);
+        return t;
+    }
+    // Task was run by runPendingTask(), any thread
+    void helped(){
+        helped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    PoolMetricsSnapshot snapshot(std::size_t queueDepth) const{
+        PoolMetricsSnapshot res;
+        res.enabled = true;
+        LatencyHistogram wait, run;
+        for(auto& s : slots_){
+            WorkerStats w;
+            w.tasks = s.tasks.load(std::memory_order_relaxed);
+            w.steals = s.steals.load(std::memory_order_relaxed);
+            w.sleeps = s.sleeps.load(std::memory_order_relaxed);
+            w.busy = std::chrono::nanoseconds(s.busyNs.load(std::memory_order_relaxed));
+            w.search = std::chrono::nanoseconds(s.searchNs.load(std::memory_order_relaxed));
+            w.sleep = std::chrono::nanoseconds(s.sleepNs.load(std::memory_order_relaxed));
+            res.total += w;
+            res.workers.push_back(w);
+            wait.merge(s.wait);
+            run.merge(s.run);
+        }
+        res.helped = helped_.load(std::memory_order_relaxed);
+        res.queueDepth = queueDepth;
+        res.maxQueueDepth = std::max(queueDepth, maxDepth_.load(std::memory_order_relaxed));
+        res.wait = statsOf(wait);
+        res.run = statsOf(run);
+        return res;
+    }
+
+    private:
+    // Counters of one worker, aligned to cache line, so workers do not share lines
+    struct alignas(64) Slot{
+        std::atomic<std::uint64_t> tasks{0};
+        std::atomic<std::uint64_t> steals{0};
+        std::atomic<std::uint64_t> sleeps{0};
+        std::atomic<std::uint64_t> busyNs{0};
+        std::atomic<std::uint64_t> searchNs{0};
+        std::atomic<std::uint64_t> sleepNs{0};
+        LatencyHistogram wait;
+        LatencyHistogram run;
+    };
+
+    // Increment by the single writer: plain load and store, no locked instruction
+    static void bump(std::atomic<std::uint64_t>& c, std::uint64_t v){
+        c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+    static void add(std::atomic<std::uint64_t>& c, Clock::duration d){
+        bump(c, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+    static WaitStats statsOf(const LatencyHistogram& h){
+        return WaitStats{h.count(), h.mean(), h.percentile(0.5), h.percentile(0.99), h.max()};
+    }
+
+    std::vector<Slot> slots_;
+    std::atomic<std::size_t> maxDepth_{0};
+    std::atomic<std::uint64_t> helped_{0};
+};
+
+#else
+
+// Metrics disabled: no state, no clock reads
+class PoolMetrics{
+    public:
+    struct Stamp{};
+
+    explicit PoolMetrics(std::size_t){}
+
+    static Stamp now(){
+        return {};
+    }
+    void queued(Task&){}
+    void depth(std::size_t){}
+    Stamp started(std::size_t, const Task&, Stamp){
+        return {};
+    }
+    Stamp finished(std::size_t, Stamp){
+        return {};
+    }
+    void stolen(std::size_t){}
+    Stamp sleeping(std::size_t, Stamp){
+        return {};
+    }
+    Stamp woke(std::size_t, Stamp){
+        return {};
+    }
+    void helped(){}
+    PoolMetricsSnapshot snapshot(std::size_t) const{
+        return {};
+    }
+};
+
+#endif
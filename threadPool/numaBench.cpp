@@ -0,0 +1,98 @@
+#include "threadPool.hpp"
+#include "topology.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Memory-bandwidth bound sums over a large buffer split into chunks
+// Every chunk is first touched (so allocated by the kernel) by a task hinted to one node,
+// later passes send the tasks of a chunk to the same node again
+// Compared: unpinned workers without hints vs Core and Node placement with hints
+// Usage: numaBench [workers] [MiB] [passes]
+
+using Mode = ThreadPool_jthread::Mode;
+using Placement = ThreadPool_jthread::Placement;
+
+constexpr std::size_t chunkBytes = 1 << 20;
+
+double run(const std::string& name, Placement placement, bool hints, std::size_t workers,
+           std::size_t chunks, std::size_t passes){
+    ThreadPool_jthread pool(workers, Mode::WorkStealing, placement);
+    constexpr std::size_t words = chunkBytes / sizeof(std::uint64_t);
+    std::vector<std::unique_ptr<std::uint64_t[]>> data(chunks);
+    std::vector<std::uint64_t> sums(chunks);
+    auto node = [&](std::size_t c){return hints ? c % pool.nodeCount() : 0;};
+    auto submit = [&](auto&& work){
+        std::vector<TaskFuture<void>> done;
+        for(std::size_t c = 0; c < chunks; c++){
+            if(hints){
+                done.push_back(pool.enqueue_on(node(c), work, c));
+            }
+            else{
+                done.push_back(pool.enqueue(work, c));
+            }
+        }
+        for(auto& f : done){
+            f.get();
+        }
+    };
+
+    // First touch: pages land on the node of the worker writing them
+    submit([&](std::size_t c){
+        data[c] = std::make_unique_for_overwrite<std::uint64_t[]>(words);
+        for(std::size_t i = 0; i < words; i++){
+            data[c][i] = i ^ c;
+        }
+    });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for(std::size_t p = 0; p < passes; p++){
+        submit([&](std::size_t c){
+            std::uint64_t s = 0;
+            for(std::size_t i = 0; i < words; i++){
+                s += data[c][i];
+            }
+            sums[c] += s;
+        });
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> sec = end - start;
+    auto gbps = static_cast<double>(chunks * chunkBytes * passes) / sec.count() / 1e9;
+
+    std::uint64_t check = 0;
+    for(auto s : sums){
+        check += s;
+    }
+    std::cout << name << ": " << gbps << " GB/s (nodes = " << pool.nodeCount()
+              << ", checksum " << check << ")" << std::endl;
+    return gbps;
+}
+
+int main(int argc, char* argv[]){
+    auto topo = CpuTopology::detect();
+    std::size_t workers = topo.cpuCount(), mib = 1024, passes = 10;
+    if(argc > 1){
+        workers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        mib = std::stoul(argv[2]);
+    }
+    if(argc > 3){
+        passes = std::stoul(argv[3]);
+    }
+    std::size_t chunks = mib * (1 << 20) / chunkBytes;
+
+    std::cout << "NUMA nodes: " << topo.nodes.size() << ", CPUs: " << topo.cpuCount()
+              << ", workers: " << workers << ", buffer: " << mib << " MiB, passes: " << passes << std::endl;
+    for(std::size_t n = 0; n < topo.nodes.size(); n++){
+        std::cout << "  node " << n << ": " << topo.nodes[n].size() << " CPUs" << std::endl;
+    }
+    auto base = run("Unpinned, no hints    ", Placement::None, false, workers, chunks, passes);
+    auto core = run("Core placement, hints ", Placement::Core, true, workers, chunks, passes);
+    auto node = run("Node placement, hints ", Placement::Node, true, workers, chunks, passes);
+    std::cout << "Speedup Core: " << core / base << "x, Node: " << node / base << "x" << std::endl;
+}
@@ -0,0 +1,118 @@
+#include "threadPool.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Benchmark of bulk submission and parallel algorithms of ThreadPool_jthread
+// against a per-element enqueue loop
+// Usage: parallelForBench [workers] [elements]
+
+using Mode = ThreadPool_jthread::Mode;
+
+// Measure wall-clock time of f in milliseconds
+template<typename F>
+double measure(F&& f){
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> ms = end - start;
+    return ms.count();
+}
+
+void run(std::size_t workers, Mode mode, std::size_t n){
+    std::vector<double> in(n), out(n);
+    std::iota(in.begin(), in.end(), 0.0);
+    auto work = [&](std::size_t i){out[i] = std::sqrt(in[i]) * 0.5 + 1.0;};
+    double expected = 0;
+    for(auto x : in){
+        expected += x;
+    }
+
+    ThreadPool_jthread pool(workers, mode);
+
+    // One task, one lock, one notify_one and one future per element
+    auto tEnqueue = measure([&]{
+        std::vector<TaskFuture<void>> futures;
+        futures.reserve(n);
+        for(std::size_t i = 0; i < n; i++){
+            futures.emplace_back(pool.enqueue(work, i));
+        }
+        for(auto& f : futures){
+            f.get();
+        }
+    });
+
+    // Still one task per element, but one lock and one broadcast for all of them
+    auto tBulk = measure([&]{
+        std::vector<std::function<void()>> tasks;
+        tasks.reserve(n);
+        for(std::size_t i = 0; i < n; i++){
+            tasks.emplace_back([&work, i]{work(i);});
+        }
+        auto futures = pool.enqueue_bulk(tasks.begin(), tasks.end());
+        for(auto& f : futures){
+            f.get();
+        }
+    });
+
+    auto tForAuto = measure([&]{
+        pool.parallel_for(std::size_t{0}, n, std::size_t{0}, work);
+    });
+
+    auto tFor1024 = measure([&]{
+        pool.parallel_for(std::size_t{0}, n, std::size_t{1024}, work);
+    });
+
+    // Sum with one future per element
+    double sumEnqueue = 0;
+    auto tSumEnqueue = measure([&]{
+        std::vector<TaskFuture<double>> futures;
+        futures.reserve(n);
+        for(std::size_t i = 0; i < n; i++){
+            futures.emplace_back(pool.enqueue([&in, i]{return in[i];}));
+        }
+        for(auto& f : futures){
+            sumEnqueue += f.get();
+        }
+    });
+
+    double sumReduce = 0;
+    auto tReduce = measure([&]{
+        sumReduce = pool.parallel_reduce(std::size_t{0}, n, std::size_t{0}, 0.0,
+            [&in](std::size_t first, std::size_t last, double acc){
+                for(auto i = first; i < last; i++){
+                    acc += in[i];
+                }
+                return acc;
+            },
+            [](double a, double b){return a + b;});
+    });
+
+    std::cout << (mode == Mode::SingleQueue ? "SingleQueue" : "WorkStealing")
+              << ", workers = " << workers << ", elements = " << n << "\n"
+              << "  enqueue loop          " << tEnqueue << " ms\n"
+              << "  enqueue_bulk          " << tBulk << " ms\n"
+              << "  parallel_for (auto)   " << tForAuto << " ms\n"
+              << "  parallel_for (1024)   " << tFor1024 << " ms\n"
+              << "  sum by enqueue loop   " << tSumEnqueue << " ms"
+              << (sumEnqueue == expected ? "" : " WRONG") << "\n"
+              << "  parallel_reduce       " << tReduce << " ms"
+              << (sumReduce == expected ? "" : " WRONG") << std::endl;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t workers = std::max(std::thread::hardware_concurrency(), 4u);
+    std::size_t n = 1000000;
+    if(argc > 1){
+        workers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        n = std::stoul(argv[2]);
+    }
+    run(workers, Mode::SingleQueue, n);
+    run(workers, Mode::WorkStealing, n);
+}
@@ -0,0 +1,52 @@
+#include "threadPool.hpp"
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Metrics of ThreadPool_jthread for a mixed workload in every scheduling mode
+// Built with THREADPOOL_METRICS (see CmakeLists.txt), without it the snapshot is empty
+// Usage: poolMetrics [workers] [tasks] [json]
+
+using Mode = ThreadPool_jthread::Mode;
+
+void runMode(const std::string& name, Mode mode, std::size_t workers, std::size_t tasks, bool json){
+    ThreadPool_jthread pool(workers, mode);
+    std::vector<TaskFuture<std::size_t>> res;
+    for(std::size_t i = 0; i < tasks; i++){
+        res.push_back(pool.enqueue([i]{
+            // Every 64th task is long, the rest are tiny
+            if(i % 64 == 0){
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            return i;
+        }));
+    }
+    for(auto& r : res){
+        r.get();
+    }
+    std::vector<int> data(1 << 20, 1);
+    pool.parallel_for(std::size_t{0}, data.size(), std::size_t{0}, [&](std::size_t i){data[i] *= 2;});
+
+    auto snapshot = pool.metrics();
+    std::cout << "== " << name << " ==\n" << (json ? snapshot.json() + "\n" : snapshot.text());
+}
+
+int main(int argc, char* argv[]){
+    std::size_t workers = 4, tasks = 20000;
+    bool json = false;
+    if(argc > 1){
+        workers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        tasks = std::stoul(argv[2]);
+    }
+    if(argc > 3){
+        json = std::string(argv[3]) == "json";
+    }
+    runMode("SingleQueue", Mode::SingleQueue, workers, tasks, json);
+    runMode("WorkStealing", Mode::WorkStealing, workers, tasks, json);
+    runMode("Priority", Mode::Priority, workers, tasks, json);
+}
@@ -0,0 +1,98 @@
+#include "threadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Latency of High priority tasks under Batch load:
+// SingleQueue (FIFO) vs Priority mode of ThreadPool_jthread
+// Usage: priorityBench [workers] [batch task ms] [high tasks]
+
+using Clock = std::chrono::steady_clock;
+using Mode = ThreadPool_jthread::Mode;
+
+// Busy work, so the batch load keeps the workers on the CPU
+void spinFor(std::chrono::microseconds d){
+    auto end = Clock::now() + d;
+    while(Clock::now() < end){
+    }
+}
+
+std::chrono::nanoseconds percentile(std::vector<std::chrono::nanoseconds> v, double q){
+    std::sort(v.begin(), v.end());
+    return v[static_cast<std::size_t>(q * (v.size() - 1))];
+}
+
+void printStats(const char* name, const WaitStats& s){
+    std::cout << "    " << name << ": count = " << s.count
+              << ", mean = " << s.mean.count() / 1000 << " us"
+              << ", p50 = " << s.p50.count() / 1000 << " us"
+              << ", p99 = " << s.p99.count() / 1000 << " us"
+              << ", max = " << s.max.count() / 1000 << " us\n";
+}
+
+void run(Mode mode, std::size_t workers, std::chrono::microseconds batchWork, std::size_t highTasks){
+    // Enough batch work to keep all workers busy while high tasks arrive
+    auto interval = std::chrono::microseconds(2000);
+    std::size_t batchTasks = workers * (highTasks * interval.count() / batchWork.count() + 1);
+    std::vector<std::chrono::nanoseconds> latency(highTasks);
+    {
+        ThreadPool_jthread pool(workers, mode);
+        std::vector<TaskFuture<void>> futures;
+        for(std::size_t i = 0; i < batchTasks; i++){
+            auto work = [batchWork]{spinFor(batchWork);};
+            if(mode == Mode::Priority){
+                futures.emplace_back(pool.enqueue(Priority::Batch, work));
+            }
+            else{
+                futures.emplace_back(pool.enqueue(work));
+            }
+        }
+        for(std::size_t i = 0; i < highTasks; i++){
+            std::this_thread::sleep_for(interval);
+            auto submitted = Clock::now();
+            auto probe = [&latency, i, submitted]{latency[i] = Clock::now() - submitted;};
+            if(mode == Mode::Priority){
+                futures.emplace_back(pool.enqueue(Priority::High, probe));
+            }
+            else{
+                futures.emplace_back(pool.enqueue(probe));
+            }
+        }
+        for(auto& f : futures){
+            f.get();
+        }
+        std::cout << (mode == Mode::Priority ? "Priority" : "SingleQueue")
+                  << ": workers = " << workers << ", batch tasks = " << batchTasks
+                  << " x " << batchWork.count() << " us, high tasks = " << highTasks << "\n"
+                  << "  High task start latency: p50 = " << percentile(latency, 0.5).count() / 1000
+                  << " us, p99 = " << percentile(latency, 0.99).count() / 1000
+                  << " us, max = " << percentile(latency, 1.0).count() / 1000 << " us\n";
+        if(mode == Mode::Priority){
+            std::cout << "  Queue wait reported by the pool:\n";
+            printStats("High  ", pool.waitStats(Priority::High));
+            printStats("Normal", pool.waitStats(Priority::Normal));
+            printStats("Batch ", pool.waitStats(Priority::Batch));
+        }
+    }
+}
+
+int main(int argc, char* argv[]){
+    std::size_t workers = 4;
+    std::chrono::microseconds batchWork(1000);
+    std::size_t highTasks = 200;
+    if(argc > 1){
+        workers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        batchWork = std::chrono::microseconds(std::stoul(argv[2]) * 1000);
+    }
+    if(argc > 3){
+        highTasks = std::stoul(argv[3]);
+    }
+    run(Mode::SingleQueue, workers, batchWork, highTasks);
+    run(Mode::Priority, workers, batchWork, highTasks);
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "histogram.hpp"
+#include "task.hpp"
+
+// Priority class of a task
+enum class Priority : std::size_t{
+    High = 0,
+    Normal = 1,
+    Batch = 2
+};
+constexpr std::size_t priorityCount = 3;
+
+// Scheduling parameters of a task: priority class and optional deadline
+struct Schedule{
+    using Clock = std::chrono::steady_clock;
+
+    Priority priority = Priority::Normal;
+    std::optional<Clock::time_point> deadline;
+
+    Schedule() = default;
+    Schedule(Priority p) : priority(p){}
+    Schedule(Clock::time_point d) : deadline(d){}
+    Schedule(Priority p, Clock::time_point d) : priority(p), deadline(d){}
+};
+
+// Queue wait time of one priority class
+struct WaitStats{
+    std::uint64_t count;
+    std::chrono::nanoseconds mean;
+    std::chrono::nanoseconds p50;
+    std::chrono::nanoseconds p99;
+    std::chrono::nanoseconds max;
+};
+
+// Scheduler queue with priority classes, deadlines and anti-starvation aging
+// - every class has its own heap ordered by deadline (earliest first);
+//   a task without deadline gets the implicit deadline "enqueue time + implicitDeadline",
+//   so tasks of one class without deadlines keep FIFO order
+// - pop() takes the class with the best effective priority:
+//   the class index minus one for every agingStep its head has waited (not better than High),
+//   ties go to the higher class, so High tasks are never delayed by aging alone
+// - every fairEvery-th pop() takes the class whose head was enqueued first,
+//   so even a flood of High tasks can not starve the other classes
+// Not thread-safe: the owner guards push/pop with its mutex, stats may be read at any time
+class PriorityTaskQueue{
+    public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options{
+        std::chrono::nanoseconds implicitDeadline = std::chrono::milliseconds(10);
+        std::chrono::nanoseconds agingStep = std::chrono::milliseconds(20);
+        std::size_t fairEvery = 16;
+    };
+
+    PriorityTaskQueue() : PriorityTaskQueue(Options{}){}
+    explicit PriorityTaskQueue(Options options) : options_(options){}
+
+    void push(Task task, const Schedule& s){
+        auto now = Clock::now();
+        auto key = s.deadline ? *s.deadline : now + options_.implicitDeadline;
+        auto& heap = heaps_[static_cast<std::size_t>(s.priority)];
+        heap.push_back(Entry{key, seq_++, now, std::move(task)});
+        std::push_heap(heap.begin(), heap.end(), later);
+        size_++;
+    }
+
+    // Take the next task and record how long it waited
+    Task pop(){
+        auto now = Clock::now();
+        auto cls = pickClass(now);
+        auto& heap = heaps_[cls];
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto entry = std::move(heap.back());
+        heap.pop_back();
+        size_--;
+        wait_[cls].record(now - entry.enqueued);
+        return std::move(entry.task);
+    }
+
+    bool empty() const{
+        return size_ == 0;
+    }
+    std::size_t size() const{
+        return size_;
+    }
+
+    WaitStats waitStats(Priority p) const{
+        auto& h = wait_[static_cast<std::size_t>(p)];
+        return WaitStats{h.count(), h.mean(), h.percentile(0.5), h.percentile(0.99), h.max()};
+    }
+    void resetStats(){
+        for(auto& h : wait_){
+            h.reset();
+        }
+    }
+
+    private:
+    struct Entry{
+        Clock::time_point key;
+        // Keeps FIFO order of tasks with equal keys
+        std::uint64_t seq;
+        Clock::time_point enqueued;
+        Task task;
+    };
+
+    // Comparator for std::*_heap: the entry with the earliest deadline is on top
+    static bool later(const Entry& a, const Entry& b){
+        return a.key != b.key ? a.key > b.key : a.seq > b.seq;
+    }
+
+    // Class of the next task, at least one heap is not empty
+    std::size_t pickClass(Clock::time_point now){
+        std::size_t best = priorityCount;
+        if(++pops_ % options_.fairEvery == 0){
+            for(std::size_t c = 0; c < priorityCount; c++){
+                if(!heaps_[c].empty() && (best == priorityCount || heaps_[c].front().enqueued < heaps_[best].front().enqueued)){
+                    best = c;
+                }
+            }
+            return best;
+        }
+        std::size_t bestEff = priorityCount;
+        for(std::size_t c = 0; c < priorityCount; c++){
+            if(heaps_[c].empty()){
+                continue;
+            }
+            auto steps = static_cast<std::size_t>((now - heaps_[c].front().enqueued) / options_.agingStep);
+            auto eff = c > steps ? c - steps : 0;
+            if(eff < bestEff){
+                best = c;
+                bestEff = eff;
+            }
+        }
+        return best;
+    }
+
+    Options options_;
+    std::array<std::vector<Entry>, priorityCount> heaps_;
+    std::size_t size_ = 0;
+    std::uint64_t seq_ = 0;
+    std::uint64_t pops_ = 0;
+    std::array<LatencyHistogram, priorityCount> wait_;
+};
@@ -0,0 +1,320 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// Move-only callable void() with small-buffer storage
+// Callables up to bufferSize bytes (with nothrow move) are stored inline without heap allocation,
+// bigger ones are stored on the heap
+// With THREADPOOL_METRICS the task also carries the time it was queued (see metrics.hpp)
+class Task{
+    public:
+    static constexpr std::size_t bufferSize = 48;
+
+    Task() noexcept = default;
+
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f){
+        using Fn = std::decay_t<F>;
+        if constexpr(fitsInline<Fn>){
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &inlineOps<Fn>;
+        }
+        else{
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+            ops_ = &heapOps<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept : ops_(other.ops_){
+#if defined(THREADPOOL_METRICS)
+        queuedAt_ = other.queuedAt_;
+#endif
+        if(ops_){
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept{
+        if(this != &other){
+            reset();
+#if defined(THREADPOOL_METRICS)
+            queuedAt_ = other.queuedAt_;
+#endif
+            if(other.ops_){
+                other.ops_->move(storage_, other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task(){
+        reset();
+    }
+
+    void operator()(){
+        ops_->invoke(storage_);
+    }
+
+    explicit operator bool() const noexcept{
+        return ops_ != nullptr;
+    }
+
+    // Destroy the stored callable
+    void reset() noexcept{
+        if(ops_){
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+#if defined(THREADPOOL_METRICS)
+    // Time the task was put in a queue of the pool (default value if it was not)
+    std::chrono::steady_clock::time_point queuedAt() const noexcept{
+        return queuedAt_;
+    }
+    void stamp(std::chrono::steady_clock::time_point t) noexcept{
+        queuedAt_ = t;
+    }
+#endif
+
+    private:
+    // Type-erased operations on the stored callable
+    struct Ops{
+        void (*invoke)(void*);
+        // Move-construct callable from src into dst and destroy src
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template<typename Fn>
+    static constexpr bool fitsInline = sizeof(Fn) <= bufferSize
+                                    && alignof(Fn) <= alignof(std::max_align_t)
+                                    && std::is_nothrow_move_constructible_v<Fn>;
+
+    template<typename Fn>
+    static constexpr Ops inlineOps{
+        [](void* p){(*static_cast<Fn*>(p))();},
+        [](void* dst, void* src) noexcept{
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) noexcept{static_cast<Fn*>(p)->~Fn();}
+    };
+
+    template<typename Fn>
+    static constexpr Ops heapOps{
+        [](void* p){(**static_cast<Fn**>(p))();},
+        [](void* dst, void* src) noexcept{::new (dst) Fn*(*static_cast<Fn**>(src));},
+        [](void* p) noexcept{delete *static_cast<Fn**>(p);}
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[bufferSize];
+    const Ops* ops_ = nullptr;
+#if defined(THREADPOOL_METRICS)
+    std::chrono::steady_clock::time_point queuedAt_{};
+#endif
+};
+
+namespace detail{
+
+// Result part of the shared state seen by TaskFuture
+template<typename R>
+class TaskResult{
+    public:
+    // References are stored as pointers, void as an empty value
+    using Value = std::conditional_t<std::is_void_v<R>, std::monostate,
+                  std::conditional_t<std::is_reference_v<R>, std::remove_reference_t<R>*, R>>;
+
+    virtual ~TaskResult() = default;
+
+    void wait() const{
+        ready_.wait(false, std::memory_order_acquire);
+    }
+    bool isReady() const{
+        return ready_.load(std::memory_order_acquire);
+    }
+    R take(){
+        if(error_){
+            std::rethrow_exception(error_);
+        }
+        if constexpr(std::is_void_v<R>){
+            return;
+        }
+        else if constexpr(std::is_reference_v<R>){
+            return static_cast<R>(**value_);
+        }
+        else{
+            return std::move(*value_);
+        }
+    }
+    // Drop one of two references (future and task), the last one deletes the state
+    void release(){
+        if(refs_.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            delete this;
+        }
+    }
+
+    protected:
+    template<typename F>
+    void setFrom(F& f){
+        try{
+            if constexpr(std::is_void_v<R>){
+                f();
+            }
+            else if constexpr(std::is_reference_v<R>){
+                value_.emplace(std::addressof(static_cast<R>(f())));
+            }
+            else{
+                value_.emplace(f());
+            }
+        }
+        catch(...){
+            error_ = std::current_exception();
+        }
+        publish();
+    }
+    void setError(std::exception_ptr e){
+        error_ = std::move(e);
+        publish();
+    }
+
+    private:
+    void publish(){
+        ready_.store(true, std::memory_order_release);
+        ready_.notify_all();
+    }
+
+    std::atomic<std::uint32_t> refs_{2};
+    std::atomic<bool> ready_{false};
+    std::optional<Value> value_;
+    std::exception_ptr error_;
+};
+
+// Shared state which also owns the callable, so a task costs one allocation
+template<typename R, typename F>
+class TaskState final : public TaskResult<R>{
+    public:
+    explicit TaskState(F&& f) : f_(std::move(f)){}
+
+    void run(){
+        this->setFrom(f_);
+        ran_ = true;
+    }
+    // Called when the task side drops the state
+    void abandon(){
+        if(!ran_){
+            this->setError(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+        this->release();
+    }
+
+    private:
+    F f_;
+    bool ran_ = false;
+};
+
+// Task side handle of the shared state, small enough to be stored inline in Task
+template<typename R, typename F>
+class TaskRunner{
+    public:
+    explicit TaskRunner(TaskState<R, F>* state) noexcept : state_(state){}
+    TaskRunner(TaskRunner&& other) noexcept : state_(std::exchange(other.state_, nullptr)){}
+    TaskRunner(const TaskRunner&) = delete;
+    ~TaskRunner(){
+        if(state_){
+            state_->abandon();
+        }
+    }
+    void operator()(){
+        state_->run();
+    }
+
+    private:
+    TaskState<R, F>* state_;
+};
+
+} // namespace detail
+
+// Future for the result of a Task created by packageTask
+// Move-only, get() may be called once like std::future::get()
+template<typename R>
+class TaskFuture{
+    public:
+    TaskFuture() noexcept = default;
+    explicit TaskFuture(detail::TaskResult<R>* state) noexcept : state_(state){}
+    TaskFuture(TaskFuture&& other) noexcept : state_(std::exchange(other.state_, nullptr)){}
+    TaskFuture& operator=(TaskFuture&& other) noexcept{
+        if(this != &other){
+            if(state_){
+                state_->release();
+            }
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+    TaskFuture(const TaskFuture&) = delete;
+    TaskFuture& operator=(const TaskFuture&) = delete;
+    ~TaskFuture(){
+        if(state_){
+            state_->release();
+        }
+    }
+
+    bool valid() const noexcept{
+        return state_ != nullptr;
+    }
+    bool is_ready() const{
+        return state_->isReady();
+    }
+    void wait() const{
+        state_->wait();
+    }
+    // Wait for the result and return it (or rethrow the exception of the task)
+    R get(){
+        if(!state_){
+            throw std::future_error(std::future_errc::no_state);
+        }
+        state_->wait();
+        // Release the state even if take() throws
+        struct Releaser{
+            detail::TaskResult<R>* s;
+            ~Releaser(){s->release();}
+        } releaser{std::exchange(state_, nullptr)};
+        return releaser.s->take();
+    }
+
+    private:
+    detail::TaskResult<R>* state_ = nullptr;
+};
+
+// Bind function with arguments into a Task and the future for its result
+// The callable and the result share one heap allocation
+template<typename F, typename ...Args>
+auto packageTask(F&& f, Args&& ...args)
+    -> std::pair<Task, TaskFuture<std::invoke_result_t<F, Args...>>>
+{
+    using R = std::invoke_result_t<F, Args...>;
+    auto fn = [f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable -> R{
+        return f(args...);
+    };
+    using Fn = decltype(fn);
+    auto* state = new detail::TaskState<R, Fn>(std::move(fn));
+    return {Task(detail::TaskRunner<R, Fn>(state)), TaskFuture<R>(state)};
+}
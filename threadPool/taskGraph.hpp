@@ -0,0 +1,170 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "threadPool.hpp"
+
+// Graph of tasks with dependencies executed on ThreadPool_jthread
+// Every node has an atomic counter of unfinished predecessors,
+// the node finishing last releases the successor, so no worker ever blocks on a dependency
+// A graph may be run many times: the counters are allocated once and only reset before a run
+// One graph must not be run concurrently with itself or modified while it runs
+class TaskGraph{
+    public:
+    using Node = std::size_t;
+
+    template<typename F>
+    Node addNode(F&& f){
+        nodes_.push_back(NodeData{std::function<void()>(std::forward<F>(f)), {}, 0});
+        dirty_ = true;
+        return nodes_.size() - 1;
+    }
+
+    // Node "to" runs only after node "from" is finished
+    void addEdge(Node from, Node to){
+        if(from >= nodes_.size() || to >= nodes_.size()){
+            throw std::out_of_range("TaskGraph::addEdge: unknown node");
+        }
+        nodes_[from].successors.push_back(to);
+        nodes_[to].predecessors++;
+        dirty_ = true;
+    }
+
+    std::size_t size() const{
+        return nodes_.size();
+    }
+
+    // Run all nodes on the pool and wait for them
+    // The calling thread executes queued tasks while waiting,
+    // so run() may be called from a task of the same pool
+    // The first exception thrown by a node is rethrown, nodes not started yet are skipped
+    void run(ThreadPool_jthread& pool){
+        if(dirty_){
+            prepare();
+        }
+        if(nodes_.empty()){
+            return;
+        }
+        pool_ = &pool;
+        for(std::size_t i = 0; i < nodes_.size(); i++){
+            pending_[i].store(nodes_[i].predecessors, std::memory_order_relaxed);
+        }
+        remaining_.store(nodes_.size(), std::memory_order_relaxed);
+        finished_.store(false, std::memory_order_relaxed);
+        failed_.store(false, std::memory_order_relaxed);
+        error_ = nullptr;
+        // post() publishes the reset counters to the workers
+        for(auto root : roots_){
+            pool.post([this, root]{this->execute(root);});
+        }
+        while(true){
+            auto remaining = remaining_.load(std::memory_order_acquire);
+            if(remaining == 0){
+                break;
+            }
+            if(!pool.runPendingTask()){
+                remaining_.wait(remaining, std::memory_order_acquire);
+            }
+        }
+        // The last node may still be inside notify_all(), wait until it leaves the graph
+        while(!finished_.load(std::memory_order_acquire)){
+            std::this_thread::yield();
+        }
+        if(error_){
+            std::rethrow_exception(error_);
+        }
+    }
+
+    private:
+    struct NodeData{
+        std::function<void()> work;
+        std::vector<Node> successors;
+        std::size_t predecessors;
+    };
+
+    // Find roots, check that the graph has no cycles and allocate counters
+    void prepare(){
+        roots_.clear();
+        std::vector<std::size_t> indegree(nodes_.size());
+        std::vector<Node> order;
+        order.reserve(nodes_.size());
+        for(std::size_t i = 0; i < nodes_.size(); i++){
+            indegree[i] = nodes_[i].predecessors;
+            if(indegree[i] == 0){
+                roots_.push_back(i);
+                order.push_back(i);
+            }
+        }
+        // Kahn's algorithm: every node is reached only if there is no cycle
+        for(std::size_t k = 0; k < order.size(); k++){
+            for(auto s : nodes_[order[k]].successors){
+                if(--indegree[s] == 0){
+                    order.push_back(s);
+                }
+            }
+        }
+        if(order.size() != nodes_.size()){
+            throw std::logic_error("TaskGraph has a cycle");
+        }
+        if(pending_.size() != nodes_.size()){
+            pending_ = std::vector<std::atomic<std::size_t>>(nodes_.size());
+        }
+        dirty_ = false;
+    }
+
+    // Run the node and the chain of successors it releases
+    // The first released successor continues on this thread, the others go to the pool
+    void execute(Node n){
+        while(true){
+            if(!failed_.load(std::memory_order_relaxed)){
+                try{
+                    nodes_[n].work();
+                }
+                catch(...){
+                    if(!failed_.exchange(true)){
+                        error_ = std::current_exception();
+                    }
+                }
+            }
+            Node next = nodes_.size();
+            for(auto s : nodes_[n].successors){
+                if(pending_[s].fetch_sub(1, std::memory_order_acq_rel) == 1){
+                    if(next == nodes_.size()){
+                        next = s;
+                    }
+                    else{
+                        pool_->post([this, s]{this->execute(s);});
+                    }
+                }
+            }
+            bool hasNext = next != nodes_.size();
+            if(remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                remaining_.notify_all();
+                finished_.store(true, std::memory_order_release);
+                // The graph may be destroyed from here on
+                return;
+            }
+            if(!hasNext){
+                return;
+            }
+            n = next;
+        }
+    }
+
+    std::vector<NodeData> nodes_;
+    std::vector<Node> roots_;
+    std::vector<std::atomic<std::size_t>> pending_;
+    bool dirty_ = false;
+
+    // State of the current run
+    ThreadPool_jthread* pool_ = nullptr;
+    std::atomic<std::size_t> remaining_{0};
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;
+};
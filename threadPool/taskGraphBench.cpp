@@ -0,0 +1,120 @@
+#include "taskGraph.hpp"
+#include "threadPool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// TaskGraph vs the same dependency graph expressed with futures
+// The graph has depth layers of width nodes, every node depends on two nodes of the previous layer
+// Usage: taskGraphBench [workers] [width] [depth] [runs]
+
+using Mode = ThreadPool_jthread::Mode;
+
+// Measure wall-clock time of f in milliseconds
+template<typename F>
+double measure(F&& f){
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> ms = end - start;
+    return ms.count();
+}
+
+// Tiny work of a node
+void nodeWork(std::atomic<std::size_t>& counter){
+    counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Build the graph once and run it many times
+double runGraph(Mode mode, std::size_t workers, std::size_t width, std::size_t depth, std::size_t runs,
+                std::atomic<std::size_t>& counter){
+    ThreadPool_jthread pool(workers, mode);
+    TaskGraph graph;
+    std::vector<TaskGraph::Node> prev, cur;
+    for(std::size_t d = 0; d < depth; d++){
+        cur.clear();
+        for(std::size_t i = 0; i < width; i++){
+            auto node = graph.addNode([&counter]{nodeWork(counter);});
+            if(d > 0){
+                graph.addEdge(prev[i], node);
+                graph.addEdge(prev[(i + 1) % width], node);
+            }
+            cur.push_back(node);
+        }
+        std::swap(prev, cur);
+    }
+    return measure([&]{
+        for(std::size_t r = 0; r < runs; r++){
+            graph.run(pool);
+        }
+    });
+}
+
+// Every node is a pool task blocking on the shared futures of its predecessors
+// Tasks are enqueued in topological order into a FIFO queue, otherwise this could deadlock
+double runFutures(std::size_t workers, std::size_t width, std::size_t depth, std::size_t runs,
+                  std::atomic<std::size_t>& counter){
+    ThreadPool_jthread pool(workers, Mode::SingleQueue);
+    return measure([&]{
+        for(std::size_t r = 0; r < runs; r++){
+            std::vector<std::shared_future<void>> prev, cur;
+            std::vector<TaskFuture<void>> all;
+            for(std::size_t d = 0; d < depth; d++){
+                cur.clear();
+                for(std::size_t i = 0; i < width; i++){
+                    std::promise<void> done;
+                    cur.push_back(done.get_future().share());
+                    std::shared_future<void> a, b;
+                    if(d > 0){
+                        a = prev[i];
+                        b = prev[(i + 1) % width];
+                    }
+                    all.push_back(pool.enqueue([&counter, a, b, done = std::move(done)]() mutable {
+                        if(a.valid()){
+                            a.get();
+                            b.get();
+                        }
+                        nodeWork(counter);
+                        done.set_value();
+                    }));
+                }
+                std::swap(prev, cur);
+            }
+            for(auto& f : all){
+                f.get();
+            }
+        }
+    });
+}
+
+int main(int argc, char* argv[]){
+    std::size_t workers = 4, width = 16, depth = 64, runs = 200;
+    if(argc > 1){
+        workers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        width = std::stoul(argv[2]);
+    }
+    if(argc > 3){
+        depth = std::stoul(argv[3]);
+    }
+    if(argc > 4){
+        runs = std::stoul(argv[4]);
+    }
+    std::size_t nodes = width * depth * runs;
+    std::atomic<std::size_t> counter{0};
+
+    auto tFutures = runFutures(workers, width, depth, runs, counter);
+    auto tGraphSingle = runGraph(Mode::SingleQueue, workers, width, depth, runs, counter);
+    auto tGraphStealing = runGraph(Mode::WorkStealing, workers, width, depth, runs, counter);
+
+    std::cout << "Graph " << width << " x " << depth << ", " << runs << " runs, " << workers << " workers\n"
+              << "Futures chain:           " << tFutures << " ms (" << tFutures * 1e6 / nodes << " ns/node)\n"
+              << "TaskGraph SingleQueue:   " << tGraphSingle << " ms (" << tGraphSingle * 1e6 / nodes << " ns/node)\n"
+              << "TaskGraph WorkStealing:  " << tGraphStealing << " ms (" << tGraphStealing * 1e6 / nodes << " ns/node)\n"
+              << "Executed nodes: " << counter.load() << " of " << 3 * nodes << std::endl;
+}
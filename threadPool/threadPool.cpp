@@ -10,7 +10,7 @@ int main() {
         auto start = std::chrono::high_resolution_clock::now();
         ThreadPool_jthread pool(4);
 
-        std::vector<std::future<int>> results;
+        std::vector<TaskFuture<int>> results;
         results.reserve(8);
 
         // mutex fpr cout
@@ -54,7 +54,7 @@ int main() {
         auto start = std::chrono::high_resolution_clock::now();
         ThreadPool_thread pool(4);
 
-        std::vector<std::future<int>> results;
+        std::vector<TaskFuture<int>> results;
         results.reserve(8);
 
         // mutex fpr cout
@@ -1,103 +1,889 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <deque>
-#include <memory>
+#include <exception>
 #include <stdexcept>
 #include <vector>
 #include <stop_token>
 #include <thread>
-#include <deque>
 #include <mutex>
 #include <condition_variable>
-#include <functional>
+#include <coroutine>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <type_traits>
 #include <future>
 #include <utility>
+#include "metrics.hpp"
+#include "priorityQueue.hpp"
+#include "task.hpp"
+#include "topology.hpp"
 
 class ThreadPool_jthread{
     public:
-    ThreadPool_jthread(std::size_t n) : N_(n){
-        for(auto i = 0; i < N_; i++){
-            threads.emplace_back(
-                [this](std::stop_token st){this->threadFunc(st);}
-            );
+    // Scheduling strategy of the pool
+    // SingleQueue  - every worker takes tasks from one deque guarded by one mutex
+    // WorkStealing - every worker owns a deque: the owner pushes and pops at the back (LIFO),
+    //                idle workers steal from the front of other deques (FIFO),
+    //                tasks submitted from outside the pool go through the injection queue
+    // Priority     - one shared earliest-deadline-first queue (see PriorityTaskQueue),
+    //                tasks may be enqueued with a priority class and/or a deadline
+    enum class Mode{
+        SingleQueue,
+        WorkStealing,
+        Priority
+    };
+    // Placement of workers on CPUs (Linux only, elsewhere workers stay unpinned)
+    // None - workers are not pinned, all of them belong to node 0
+    // Core - every worker is pinned to one CPU, workers are spread over NUMA nodes round-robin
+    // Node - every worker is pinned to all CPUs of one NUMA node, nodes are used round-robin
+    // With Core and Node placement in WorkStealing mode tasks may get a node hint (post_on / enqueue_on)
+    // and idle workers steal inside their node before they steal from other nodes
+    enum class Placement{
+        None,
+        Core,
+        Node
+    };
+
+    // Limits of an elastic pool
+    // A worker is added when a queued task has waited longer than growAfter,
+    // a worker sleeping longer than idleTimeout retires while more than minWorkers are alive
+    struct Elastic{
+        std::size_t minWorkers = 1;
+        std::size_t maxWorkers = 0;
+        std::chrono::microseconds growAfter{std::chrono::milliseconds(2)};
+        std::chrono::microseconds idleTimeout{std::chrono::milliseconds(500)};
+    };
+
+    ThreadPool_jthread(std::size_t n, Mode mode = Mode::SingleQueue, Placement placement = Placement::None)
+        : N_(n), mode_(mode), placement_(placement), locals_(mode == Mode::WorkStealing ? n : 0), metrics_(n),
+          live_(n, true), active_(n), threads(n){
+        placeWorkers();
+        for(std::size_t i = 0; i < N_; i++){
+            startWorker(i);
         }
     }
+    // Elastic pool: starts with minWorkers and grows up to maxWorkers under load
+    // Per-worker structures are allocated for maxWorkers up front, so resizing never moves them
+    ThreadPool_jthread(Elastic elastic, Mode mode = Mode::SingleQueue, Placement placement = Placement::None)
+        : N_(std::max(elastic.maxWorkers, std::max<std::size_t>(elastic.minWorkers, 1))), mode_(mode), placement_(placement),
+          locals_(mode == Mode::WorkStealing ? N_ : 0), metrics_(N_), live_(N_, false), threads(N_){
+        elastic.minWorkers = std::max<std::size_t>(elastic.minWorkers, 1);
+        elastic.maxWorkers = N_;
+        elastic_ = elastic;
+        placeWorkers();
+        for(std::size_t i = 0; i < elastic.minWorkers; i++){
+            live_[i] = true;
+            active_.fetch_add(1, std::memory_order_relaxed);
+            startWorker(i);
+        }
+        controller_ = std::jthread([this, st = stopSource.get_token()]{this->controllerFunc(st);});
+    }
     ~ThreadPool_jthread(){
         shoutdown();
     }
     // Function to join all threads
     void shoutdown(){
-        if(stopSource.stop_possible()){
-            stopSource.request_stop();
+        // request_stop() returns true only for the first call
+        if(stopSource.request_stop()){
+            // Take the mutex, so a worker can not miss the notification
+            // between checking the predicate and going to sleep
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+            }
             cv_.notify_all();
+            for(auto& node : nodes_){
+                node.cv.notify_all();
+            }
+            // The controller is the only other thread starting workers, stop it first
+            if(controller_.joinable()){
+                controller_.join();
+            }
             for(auto& t : threads){
-                t.join();
+                if(t.joinable()){
+                    t.join();
+                }
             }
-            if(queue_.empty()){
+            if(queue_.empty() && prio_.empty()){
                 std::cout << "All right! Queue is empty and threads ara joined\n";
             }
         }
     }
     // Function to add task in threadPool
     template<typename F, typename ...Args>
-    auto enqueue(F&& f, Args... args) -> std::future<std::invoke_result_t<F, Args...>>{
+    auto enqueue(F&& f, Args... args) -> TaskFuture<std::invoke_result_t<F, Args...>>{
         // Check for shoutdown threadPool
         // If stopSource is stopped, throw exception
         if(stopSource.stop_requested()){
             throw std::runtime_error("enqueue on stopped ThreadPool");
         }
-        using R = std::invoke_result_t<F, Args...>;
-        // Create a packaged task to store the result of the function
-        // Make it shared to be able to use it in the thread
-        // and return future to the user
-        // Use std::forward and mutable to preserve the value category of the arguments
-        // and allow perfect forwarding
-        auto packPtr = std::make_shared<std::packaged_task<R()>>(
-            [f = std::forward<F>(f), ...args = std::forward<Args>(args)] () mutable {
-                return f(args...);
-            }
-        );
-        auto res = packPtr->get_future();
-        // Lock the mutex to safely access the queue
-        // and then notify to wake up one of the threads
+        // Bind the function with its arguments into a Task
+        // The callable and the result for the future share one allocation
+        auto [task, res] = packageTask(std::forward<F>(f), std::move(args)...);
+        push(std::move(task));
+        return std::move(res);
+    }
+    // Function to add task in threadPool with a hint to run it on the NUMA node
+    // The hint is used in WorkStealing mode only, node is taken modulo nodeCount()
+    template<typename F, typename ...Args>
+    auto enqueue_on(std::size_t node, F&& f, Args... args) -> TaskFuture<std::invoke_result_t<F, Args...>>{
+        if(stopSource.stop_requested()){
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        auto [task, res] = packageTask(std::forward<F>(f), std::move(args)...);
+        pushToNode(node, std::move(task));
+        return std::move(res);
+    }
+    // Function to add task with priority class and/or deadline in threadPool
+    // Available only in Priority mode
+    template<typename F, typename ...Args>
+    auto enqueue(Schedule schedule, F&& f, Args... args) -> TaskFuture<std::invoke_result_t<F, Args...>>{
+        if(mode_ != Mode::Priority){
+            throw std::logic_error("enqueue with Schedule requires Mode::Priority");
+        }
+        if(stopSource.stop_requested()){
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        auto [task, res] = packageTask(std::forward<F>(f), std::move(args)...);
+        metrics_.queued(task);
+        submitted(1);
         {
             std::lock_guard<std::mutex> lk(mtx_);
-            queue_.emplace_back([packPtr]{(*packPtr());});
+            prio_.push(std::move(task), schedule);
+            metrics_.depth(prio_.size());
         }
         cv_.notify_one();
+        return std::move(res);
+    }
+    // Function to add task without result in threadPool
+    // Small callables are stored inside the Task, so no allocation is needed
+    template<typename F, typename ...Args>
+    void post(F&& f, Args... args){
+        if(stopSource.stop_requested()){
+            throw std::runtime_error("post on stopped ThreadPool");
+        }
+        if constexpr(sizeof...(Args) == 0){
+            push(Task(std::forward<F>(f)));
+        }
+        else{
+            push(Task([f = std::forward<F>(f), ...args = std::move(args)]() mutable {
+                f(args...);
+            }));
+        }
+    }
+    // Function to add task without result with a hint to run it on the NUMA node
+    template<typename F, typename ...Args>
+    void post_on(std::size_t node, F&& f, Args... args){
+        if(stopSource.stop_requested()){
+            throw std::runtime_error("post on stopped ThreadPool");
+        }
+        if constexpr(sizeof...(Args) == 0){
+            pushToNode(node, Task(std::forward<F>(f)));
+        }
+        else{
+            pushToNode(node, Task([f = std::forward<F>(f), ...args = std::move(args)]() mutable {
+                f(args...);
+            }));
+        }
+    }
+    // Function to add a range of tasks in threadPool
+    // All tasks are queued under one lock and workers are woken up by one broadcast
+    template<typename It>
+    auto enqueue_bulk(It first, It last) -> std::vector<TaskFuture<std::invoke_result_t<std::iter_reference_t<It>>>>{
+        if(stopSource.stop_requested()){
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        std::vector<TaskFuture<std::invoke_result_t<std::iter_reference_t<It>>>> res;
+        std::vector<Task> tasks;
+        for(; first != last; ++first){
+            auto [task, fut] = packageTask(*first);
+            tasks.emplace_back(std::move(task));
+            res.emplace_back(std::move(fut));
+        }
+        pushBulk(tasks);
         return res;
     }
+    // Call f(i) for every i in [begin, end)
+    // The range is split into chunks of grain indices (grain == 0 selects the size automatically),
+    // chunks are distributed by recursive halving and the calling thread takes part in the work
+    // The first exception thrown by f is rethrown after all chunks are finished
+    template<typename Index, typename F>
+    void parallel_for(Index begin, Index end, Index grain, F&& f){
+        if(!(begin < end)){
+            return;
+        }
+        std::size_t n = static_cast<std::size_t>(end - begin);
+        std::size_t g = grain > 0 ? static_cast<std::size_t>(grain) : autoGrain(n);
+        auto chunk = [&](std::size_t c){
+            Index first = begin + static_cast<Index>(c * g);
+            Index last = begin + static_cast<Index>(std::min(n, (c + 1) * g));
+            for(Index i = first; i < last; ++i){
+                f(i);
+            }
+        };
+        forkJoin((n + g - 1) / g, chunk);
+    }
+    // Reduce [begin, end) in parallel
+    // body(first, last, identity) reduces one chunk, join(a, b) combines results of two chunks
+    // Chunk results are joined in index order, so the result does not depend on scheduling
+    template<typename Index, typename T, typename Body, typename Join>
+    T parallel_reduce(Index begin, Index end, Index grain, T identity, Body&& body, Join&& join){
+        if(!(begin < end)){
+            return identity;
+        }
+        std::size_t n = static_cast<std::size_t>(end - begin);
+        std::size_t g = grain > 0 ? static_cast<std::size_t>(grain) : autoGrain(n);
+        std::size_t chunks = (n + g - 1) / g;
+        std::vector<T> partial(chunks, identity);
+        auto chunk = [&](std::size_t c){
+            Index first = begin + static_cast<Index>(c * g);
+            Index last = begin + static_cast<Index>(std::min(n, (c + 1) * g));
+            partial[c] = body(first, last, identity);
+        };
+        forkJoin(chunks, chunk);
+        T res = std::move(identity);
+        for(auto& p : partial){
+            res = join(std::move(res), std::move(p));
+        }
+        return res;
+    }
+    // Awaitable for coroutines: co_await pool.schedule() suspends the coroutine
+    // and resumes it on a worker of the pool
+    auto schedule(){
+        struct Awaiter{
+            ThreadPool_jthread* pool;
+            bool await_ready() const noexcept{
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> h){
+                pool->post([h]{h.resume();});
+            }
+            void await_resume() const noexcept{}
+        };
+        return Awaiter{this};
+    }
+    // Run one queued task on the calling thread
+    // Returns false if there is no task to run
+    bool runPendingTask(){
+        Task task;
+        if(!tryPop(task)){
+            return false;
+        }
+        metrics_.helped();
+        task();
+        return true;
+    }
+    // Queue wait time of the priority class (Priority mode only)
+    WaitStats waitStats(Priority p) const{
+        return prio_.waitStats(p);
+    }
+    Mode mode() const{
+        return mode_;
+    }
+    // Number of live workers (changes over time in an elastic pool)
+    std::size_t size() const{
+        return active_.load(std::memory_order_relaxed);
+    }
+    // Maximum number of workers
+    std::size_t capacity() const{
+        return N_;
+    }
+    // Number of NUMA nodes used by the workers (1 without placement)
+    std::size_t nodeCount() const{
+        return nodeWorkers_.size();
+    }
+    // NUMA node of the worker
+    std::size_t workerNode(std::size_t index) const{
+        return workerNode_[index];
+    }
+    // Counters, queue depth and latency histograms of the workers (see metrics.hpp)
+    // Empty snapshot with enabled == false unless built with THREADPOOL_METRICS
+    PoolMetricsSnapshot metrics(){
+        std::size_t depth = 0;
+        if constexpr(poolMetricsEnabled){
+            if(mode_ == Mode::WorkStealing){
+                depth = pending_.load(std::memory_order_relaxed);
+            }
+            else{
+                std::lock_guard<std::mutex> lk(mtx_);
+                depth = queue_.size() + prio_.size();
+            }
+        }
+        return metrics_.snapshot(depth);
+    }
 
 
     private:
+    // Maximum number of tasks a worker moves from the injection queue to its own deque at once
+    static constexpr std::size_t injectBatch = 32;
+
+    // Own deque of worker in WorkStealing mode
+    // Aligned to cache line, so neighbouring deques do not share it
+    struct alignas(64) LocalQueue{
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    // Queue of tasks with hint for one NUMA node and sleeping place of its workers (WorkStealing mode)
+    struct alignas(64) NodeQueue{
+        std::mutex mtx;
+        std::deque<Task> tasks;
+        // Workers of the node sleep here, guarded by mtx_ of the pool
+        std::condition_variable cv;
+        std::size_t sleeping = 0;
+    };
+
     // Queue for input tasks
-    std::deque<std::function<void()>> queue_;
+    // In WorkStealing mode it is the injection queue for tasks from outside the pool
+    std::deque<Task> queue_;
     // Mutex for safety access to queue_
     std::mutex mtx_;
     // Condition variable for safety access to queue_
     std::condition_variable cv_;
     // Number of used threads
     std::size_t N_;
-    // Vector of threads
-    std::vector<std::jthread> threads;
+    // Scheduling strategy
+    Mode mode_;
+    // Placement of workers on CPUs
+    Placement placement_;
+    // NUMA node of every worker
+    std::vector<std::size_t> workerNode_;
+    // CPUs every worker is pinned to (empty - not pinned)
+    std::vector<std::vector<int>> workerCpus_;
+    // Workers of every node
+    std::vector<std::vector<std::size_t>> nodeWorkers_;
+    // Queues for tasks with node hint (WorkStealing mode only)
+    std::vector<NodeQueue> nodes_;
+    // Queue of Priority mode
+    PriorityTaskQueue prio_;
+    // Own deques of workers (empty in SingleQueue and Priority modes)
+    std::vector<LocalQueue> locals_;
+    // Number of tasks in all deques of WorkStealing mode
+    std::atomic<std::size_t> pending_{0};
+    // Number of workers sleeping on the node condition variables in WorkStealing mode
+    std::atomic<std::size_t> sleeping_{0};
+    // Instrumentation, empty without THREADPOOL_METRICS
+    [[no_unique_address]] PoolMetrics metrics_;
+    // Limits of the elastic pool (empty for a fixed-size pool)
+    std::optional<Elastic> elastic_;
+    // Worker slot i has a running (not retired) thread, guarded by mtx_
+    std::vector<bool> live_;
+    // Number of live workers, changed under mtx_
+    std::atomic<std::size_t> active_{0};
+    // Number of tasks ever queued (elastic pool only), the controller derives the number of started tasks from it
+    std::atomic<std::size_t> submitted_{0};
     // Stop logic for threads
+    // Declared before threads, so the token is valid while workers start
     std::stop_source stopSource;
+    // Vector of threads, one slot per possible worker (slots of retired workers are reused)
+    std::vector<std::jthread> threads;
+    // Thread growing the elastic pool
+    std::jthread controller_;
+
+    // Counter of unfinished chunks of parallel_for / parallel_reduce
+    // Shared with the chunk tasks, so a chunk can notify after the caller returned
+    struct ForkJoinState{
+        std::atomic<std::size_t> remaining;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        explicit ForkJoinState(std::size_t n) : remaining(n){}
+    };
+
+    // Pool and index of the worker running on the current thread
+    // Used to push tasks submitted from a worker to its own deque
+    static inline thread_local ThreadPool_jthread* currentPool_ = nullptr;
+    static inline thread_local std::size_t currentIndex_ = 0;
+
+    // Put task in the queue of the current scheduling strategy and wake up a worker
+    void push(Task task){
+        if(mode_ != Mode::WorkStealing){
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                pushShared(std::move(task));
+            }
+            cv_.notify_one();
+            return;
+        }
+        // Count the task before it becomes visible,
+        // so a thief never decrements pending_ below zero
+        metrics_.queued(task);
+        submitted(1);
+        metrics_.depth(pending_.fetch_add(1) + 1);
+        if(currentPool_ == this){
+            auto& local = locals_[currentIndex_];
+            {
+                std::lock_guard<std::mutex> lk(local.mtx);
+                local.tasks.emplace_back(std::move(task));
+            }
+            wake(workerNode_[currentIndex_], false);
+        }
+        else{
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                queue_.emplace_back(std::move(task));
+            }
+            wake(nodes_.size(), false);
+        }
+    }
+
+    // Put task with node hint in the queue of the node
+    void pushToNode(std::size_t node, Task task){
+        if(mode_ != Mode::WorkStealing){
+            push(std::move(task));
+            return;
+        }
+        node %= nodes_.size();
+        metrics_.queued(task);
+        submitted(1);
+        metrics_.depth(pending_.fetch_add(1) + 1);
+        {
+            std::lock_guard<std::mutex> lk(nodes_[node].mtx);
+            nodes_[node].tasks.emplace_back(std::move(task));
+        }
+        wake(node, false);
+    }
+
+    // Wake up a sleeping worker in WorkStealing mode, preferably one of the node
+    // (node == nodes_.size() means any node), or all sleeping workers
+    void wake(std::size_t node, bool all){
+        // pending_ is increased before sleeping_ is read and a sleeper increases sleeping_
+        // before it reads pending_ (both seq_cst), so at least one side sees the other.
+        // Taking mtx_ guarantees the sleeper is already waiting when we notify
+        if(sleeping_.load() == 0){
+            return;
+        }
+        std::lock_guard<std::mutex> lk(mtx_);
+        if(all){
+            for(auto& n : nodes_){
+                n.cv.notify_all();
+            }
+            return;
+        }
+        if(node < nodes_.size() && nodes_[node].sleeping > 0){
+            nodes_[node].cv.notify_one();
+            return;
+        }
+        for(auto& n : nodes_){
+            if(n.sleeping > 0){
+                n.cv.notify_one();
+                return;
+            }
+        }
+    }
+
+    // Assign workers to NUMA nodes and CPUs according to placement_
+    void placeWorkers(){
+        workerNode_.assign(N_, 0);
+        workerCpus_.assign(N_, {});
+        std::size_t nodeCount = 1;
+        if(placement_ != Placement::None && N_ > 0){
+            auto topo = CpuTopology::detect();
+            nodeCount = std::min(topo.nodes.size(), N_);
+            for(std::size_t i = 0; i < N_; i++){
+                auto node = i % nodeCount;
+                auto& cpus = topo.nodes[node];
+                workerNode_[i] = node;
+                if(placement_ == Placement::Core){
+                    workerCpus_[i] = {cpus[(i / nodeCount) % cpus.size()]};
+                }
+                else{
+                    workerCpus_[i] = cpus;
+                }
+            }
+        }
+        nodeWorkers_.assign(nodeCount, {});
+        for(std::size_t i = 0; i < N_; i++){
+            nodeWorkers_[workerNode_[i]].push_back(i);
+        }
+        if(mode_ == Mode::WorkStealing){
+            nodes_ = std::vector<NodeQueue>(nodeCount);
+        }
+    }
+
+    // Queue shared by all workers in SingleQueue and Priority modes, called under mtx_
+    // Tasks without Schedule have Normal priority
+    void pushShared(Task task){
+        metrics_.queued(task);
+        submitted(1);
+        if(mode_ == Mode::Priority){
+            prio_.push(std::move(task), Schedule{});
+        }
+        else{
+            queue_.emplace_back(std::move(task));
+        }
+        metrics_.depth(queue_.size() + prio_.size());
+    }
+    bool sharedEmpty() const{
+        return mode_ == Mode::Priority ? prio_.empty() : queue_.empty();
+    }
+    Task popShared(){
+        if(mode_ == Mode::Priority){
+            return prio_.pop();
+        }
+        auto task = std::move(queue_.front());
+        queue_.pop_front();
+        return task;
+    }
+
+    // Put several tasks in the queue under one lock and wake up workers once
+    void pushBulk(std::vector<Task>& tasks){
+        if(tasks.empty()){
+            return;
+        }
+        if(mode_ != Mode::WorkStealing){
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                for(auto& t : tasks){
+                    pushShared(std::move(t));
+                }
+            }
+            cv_.notify_all();
+            return;
+        }
+        for(auto& t : tasks){
+            metrics_.queued(t);
+        }
+        submitted(tasks.size());
+        metrics_.depth(pending_.fetch_add(tasks.size()) + tasks.size());
+        if(currentPool_ == this){
+            auto& local = locals_[currentIndex_];
+            std::lock_guard<std::mutex> lk(local.mtx);
+            for(auto& t : tasks){
+                local.tasks.emplace_back(std::move(t));
+            }
+        }
+        else{
+            std::lock_guard<std::mutex> lk(mtx_);
+            for(auto& t : tasks){
+                queue_.emplace_back(std::move(t));
+            }
+        }
+        wake(nodes_.size(), true);
+    }
+
+    // Chunk size for parallel_for / parallel_reduce when grain is not given:
+    // about 8 chunks per worker to balance the load without too many tasks
+    std::size_t autoGrain(std::size_t n) const{
+        return std::max<std::size_t>(1, n / ((N_ + 1) * 8));
+    }
+
+    // Run fn(c) for every chunk c in [0, chunks) on the pool and the calling thread
+    template<typename ChunkFn>
+    void forkJoin(std::size_t chunks, ChunkFn& fn){
+        if(stopSource.stop_requested()){
+            throw std::runtime_error("parallel algorithm on stopped ThreadPool");
+        }
+        auto state = std::make_shared<ForkJoinState>(chunks);
+        forkJoinSplit(state, &fn, 0, chunks);
+        // Help with queued tasks while chunks are running,
+        // sleep until the next chunk is finished when there is nothing to do
+        while(true){
+            auto remaining = state->remaining.load(std::memory_order_acquire);
+            if(remaining == 0){
+                break;
+            }
+            if(!runPendingTask()){
+                state->remaining.wait(remaining, std::memory_order_acquire);
+            }
+        }
+        if(state->error){
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    // Give the upper half of [lo, hi) to the pool until one chunk is left, then run it
+    template<typename ChunkFn>
+    void forkJoinSplit(const std::shared_ptr<ForkJoinState>& state, ChunkFn* fn, std::size_t lo, std::size_t hi){
+        while(hi - lo > 1){
+            auto mid = lo + (hi - lo) / 2;
+            push(Task([this, state, fn, mid, hi]{this->forkJoinSplit(state, fn, mid, hi);}));
+            hi = mid;
+        }
+        // Skip the work after the first exception, but still count the chunk
+        if(!state->failed.load(std::memory_order_relaxed)){
+            try{
+                (*fn)(lo);
+            }
+            catch(...){
+                if(!state->failed.exchange(true)){
+                    state->error = std::current_exception();
+                }
+            }
+        }
+        // Every chunk wakes the caller, so it looks for split tasks pushed since it went to sleep
+        state->remaining.fetch_sub(1, std::memory_order_acq_rel);
+        state->remaining.notify_all();
+    }
+
+    // Take a task for runPendingTask() from any queue
+    bool tryPop(Task& task){
+        if(mode_ != Mode::WorkStealing){
+            std::lock_guard<std::mutex> lk(mtx_);
+            if(sharedEmpty()){
+                return false;
+            }
+            task = popShared();
+            return true;
+        }
+        bool found = currentPool_ == this ? popStealing(currentIndex_, task)
+                                          : popFrom(mtx_, queue_, task, nullptr, N_) || stealAcross(nodes_.size(), task);
+        if(found){
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return found;
+    }
 
     // Wrap function for threads
-    void threadFunc(std::stop_token sToken){
+    void threadFunc(std::stop_token sToken, std::size_t index){
+        if(!workerCpus_[index].empty()){
+            pinThisThread(workerCpus_[index]);
+        }
+        if(mode_ == Mode::WorkStealing){
+            stealingThreadFunc(sToken, index);
+            return;
+        }
+        auto ready = [this, &sToken]{return !this->sharedEmpty() || sToken.stop_requested();};
+        auto mark = metrics_.now();
         while(true){
             std::unique_lock lk(mtx_);
-            cv_.wait(lk, [this, &sToken]{return !this->queue_.empty() || sToken.stop_requested();});
-            if(queue_.empty() && sToken.stop_requested()){
+            if(!ready()){
+                auto sleepFrom = metrics_.sleeping(index, mark);
+                bool retire = !sleep(cv_, lk, index, ready);
+                mark = metrics_.woke(index, sleepFrom);
+                if(retire){
+                    break;
+                }
+            }
+            if(sharedEmpty() && sToken.stop_requested()){
                 break;
             }
-            auto task = std::move(queue_.front());
-            queue_.pop_front();
+            auto task = popShared();
             lk.unlock();
+            auto start = metrics_.started(index, task, mark);
             task();
+            mark = metrics_.finished(index, start);
+        }
+    }
+
+    // Wait on cv until ready() (mtx_ is held by lk)
+    // In an elastic pool returns false if the worker slept idleTimeout with nothing to do
+    // and was retired; the worker must leave then
+    template<typename Ready>
+    bool sleep(std::condition_variable& cv, std::unique_lock<std::mutex>& lk, std::size_t index, Ready ready){
+        if(!elastic_){
+            cv.wait(lk, ready);
+            return true;
+        }
+        while(!cv.wait_for(lk, elastic_->idleTimeout, ready)){
+            // A notification is never lost here: ready() is false under mtx_,
+            // so no task was pushed that this worker was woken for
+            if(active_.load(std::memory_order_relaxed) > elastic_->minWorkers){
+                live_[index] = false;
+                active_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Start the worker thread of slot index
+    // The thread of a retired worker is joined first, it may still be leaving threadFunc
+    void startWorker(std::size_t index){
+        if(threads[index].joinable()){
+            threads[index].join();
+        }
+        // Workers observe the pool stop source, not the own token of jthread,
+        // because shoutdown() requests stop through stopSource
+        threads[index] = std::jthread(
+            [this, index, st = stopSource.get_token()]{this->threadFunc(st, index);}
+        );
+    }
+
+    // Count queued tasks for the controller of the elastic pool
+    void submitted(std::size_t n){
+        if(elastic_){
+            submitted_.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    // Number of queued tasks
+    std::size_t queuedCount(){
+        if(mode_ == Mode::WorkStealing){
+            return pending_.load(std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lk(mtx_);
+        return queue_.size() + prio_.size();
+    }
+
+    // Thread of the elastic pool watching the queue wait time
+    // Every tick it checks whether all tasks queued before the mark have started;
+    // if some of them is still queued growAfter after the mark, workers are added
+    // (half of the live count, at least one) and the mark moves to now
+    void controllerFunc(std::stop_token sToken){
+        using Clock = std::chrono::steady_clock;
+        auto tick = std::max<Clock::duration>(elastic_->growAfter / 2, std::chrono::microseconds(100));
+        std::mutex mtx;
+        std::condition_variable_any cv;
+        auto markSubmitted = submitted_.load(std::memory_order_relaxed);
+        auto markTime = Clock::now();
+        std::unique_lock lk(mtx);
+        // Returns early when stop is requested
+        while(!cv.wait_for(lk, sToken, tick, []{return false;}) && !sToken.stop_requested()){
+            // Read the queue first, so a task pushed in between is not counted as started
+            auto queued = queuedCount();
+            auto sub = submitted_.load(std::memory_order_relaxed);
+            auto started = sub > queued ? sub - queued : 0;
+            auto now = Clock::now();
+            if(started >= markSubmitted){
+                markSubmitted = sub;
+                markTime = now;
+            }
+            else if(now - markTime >= elastic_->growAfter){
+                grow();
+                markSubmitted = sub;
+                markTime = now;
+            }
+        }
+    }
+
+    // Start new workers in free slots
+    void grow(){
+        std::vector<std::size_t> slots;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            auto live = active_.load(std::memory_order_relaxed);
+            auto add = std::min(N_ - live, std::max<std::size_t>(live / 2, 1));
+            for(std::size_t i = 0; i < N_ && slots.size() < add; i++){
+                if(!live_[i]){
+                    live_[i] = true;
+                    slots.push_back(i);
+                }
+            }
+            active_.fetch_add(slots.size(), std::memory_order_relaxed);
+        }
+        for(auto i : slots){
+            startWorker(i);
+        }
+    }
+
+    // Wrap function for threads in WorkStealing mode
+    void stealingThreadFunc(std::stop_token sToken, std::size_t index){
+        currentPool_ = this;
+        currentIndex_ = index;
+        auto& node = nodes_[workerNode_[index]];
+        Task task;
+        auto mark = metrics_.now();
+        while(true){
+            if(popStealing(index, task)){
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                auto start = metrics_.started(index, task, mark);
+                task();
+                task.reset();
+                mark = metrics_.finished(index, start);
+                continue;
+            }
+            auto sleepFrom = metrics_.sleeping(index, mark);
+            std::unique_lock lk(mtx_);
+            sleeping_.fetch_add(1);
+            node.sleeping++;
+            bool retire = !sleep(node.cv, lk, index, [this, &sToken]{return pending_.load() > 0 || sToken.stop_requested();});
+            node.sleeping--;
+            sleeping_.fetch_sub(1);
+            mark = metrics_.woke(index, sleepFrom);
+            // The deque of a retiring worker is empty: only the owner pushes to it and it found nothing
+            if(retire || (pending_.load() == 0 && sToken.stop_requested())){
+                break;
+            }
+        }
+        currentPool_ = nullptr;
+    }
+
+    // Search order of a worker: own deque, queue of own node, injection queue,
+    // deques of workers of own node, then queues and deques of other nodes
+    bool popStealing(std::size_t index, Task& task){
+        auto node = workerNode_[index];
+        auto& workers = nodeWorkers_[node];
+        if(popLocal(index, task)
+        || popFrom(nodes_[node].mtx, nodes_[node].tasks, task, &locals_[index], workers.size())
+        || popFrom(mtx_, queue_, task, &locals_[index], N_)){
+            return true;
+        }
+        // Workers are assigned to nodes round-robin, so index / nodeCount() is the position in the node
+        if(steal(workers, index / nodes_.size() + 1, workers.size() - 1, task) || stealAcross(node, task)){
+            metrics_.stolen(index);
+            return true;
+        }
+        return false;
+    }
+
+    // Take the newest task from own deque
+    bool popLocal(std::size_t index, Task& task){
+        auto& local = locals_[index];
+        std::lock_guard<std::mutex> lk(local.mtx);
+        if(local.tasks.empty()){
+            return false;
+        }
+        task = std::move(local.tasks.back());
+        local.tasks.pop_back();
+        return true;
+    }
+
+    // Take the oldest task from the shared queue (injection queue or queue of a node)
+    // and move a batch of following tasks to the deque of the worker (if any)
+    bool popFrom(std::mutex& mtx, std::deque<Task>& queue, Task& task, LocalQueue* local, std::size_t sharers){
+        std::lock_guard<std::mutex> lk(mtx);
+        if(queue.empty()){
+            return false;
+        }
+        task = std::move(queue.front());
+        queue.pop_front();
+        // Share the rest of the queue between workers, but not more than injectBatch
+        auto batch = std::min(queue.size() / sharers, injectBatch);
+        if(local && batch > 0){
+            std::lock_guard<std::mutex> localLk(local->mtx);
+            for(std::size_t i = 0; i < batch; i++){
+                local->tasks.emplace_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+        return true;
+    }
+
+    // Take the oldest task from one of count deques of workers starting with position first
+    bool steal(const std::vector<std::size_t>& workers, std::size_t first, std::size_t count, Task& task){
+        for(std::size_t i = 0; i < count; i++){
+            auto& victim = locals_[workers[(first + i) % workers.size()]];
+            // Do not wait for a busy victim, try the next one
+            std::unique_lock<std::mutex> lk(victim.mtx, std::try_to_lock);
+            if(!lk.owns_lock() || victim.tasks.empty()){
+                continue;
+            }
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
         }
+        return false;
+    }
+
+    // Take a task from queues and deques of nodes other than own (own == nodes_.size() - all nodes)
+    // Tasks of a remote node are taken one by one, so they are not moved far from their data in batches
+    bool stealAcross(std::size_t own, Task& task){
+        for(std::size_t i = 1; i <= nodes_.size(); i++){
+            auto n = (own + i) % nodes_.size();
+            if(n == own){
+                continue;
+            }
+            auto& workers = nodeWorkers_[n];
+            if(popFrom(nodes_[n].mtx, nodes_[n].tasks, task, nullptr, 1)
+            || steal(workers, 0, workers.size(), task)){
+                return true;
+            }
+        }
+        return false;
     }
 
 };
@@ -105,7 +891,8 @@ class ThreadPool_jthread{
 class ThreadPool_thread{
     private:
     // Queue for input tasks
-    std::deque<std::function<void()>> queue_;
+    // Earliest-deadline-first, tasks without Schedule have Normal priority and keep FIFO order
+    PriorityTaskQueue queue_;
     // Mutex for safety access to queue_
     std::mutex mtx_;
     // Condition variable for safety access to queue_
@@ -125,8 +912,7 @@ class ThreadPool_thread{
             if(queue_.empty() && atom.load(std::memory_order_acquire)){
                 break;
             }
-            auto task = std::move(queue_.front());
-            queue_.pop_front();
+            auto task = queue_.pop();
             lk.unlock();
             task();
         }
@@ -155,25 +941,46 @@ class ThreadPool_thread{
         }
     }
     template<typename F, typename ...Args>
-    auto enqueue(F&& f, Args&& ...args) -> std::future<std::invoke_result_t<F, Args...>>{
-        using R = std::invoke_result_t<F, Args...>;
-
+    auto enqueue(F&& f, Args&& ...args) -> TaskFuture<std::invoke_result_t<F, Args...>>{
+        return enqueue(Schedule{}, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+    // Add task with priority class and/or deadline
+    template<typename F, typename ...Args>
+    auto enqueue(Schedule schedule, F&& f, Args&& ...args) -> TaskFuture<std::invoke_result_t<F, Args...>>{
         // Check for shoutdown threadPool
         if(atom.load(std::memory_order_acquire)){
             throw std::runtime_error("enqueue on stopped ThreadPool");
         }
 
-        auto packPtr = std::make_shared<std::packaged_task<R()>>(
-            [f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable
+        auto [task, res] = packageTask(std::forward<F>(f), std::forward<Args>(args)...);
         {
-            return f(args...);
-        });
-        auto res = packPtr->get_future();
+            std::lock_guard lk(mtx_);
+            queue_.push(std::move(task), schedule);
+        }
+        cv_.notify_one();
+        return std::move(res);
+    }
+    // Queue wait time of the priority class
+    WaitStats waitStats(Priority p) const{
+        return queue_.waitStats(p);
+    }
+    // Add task without result, small callables are stored without allocation
+    template<typename F, typename ...Args>
+    void post(F&& f, Args&& ...args){
+        if(atom.load(std::memory_order_acquire)){
+            throw std::runtime_error("post on stopped ThreadPool");
+        }
         {
             std::lock_guard lk(mtx_);
-            queue_.emplace_back([packPtr]{(*packPtr)();});
+            if constexpr(sizeof...(Args) == 0){
+                queue_.push(Task(std::forward<F>(f)), Schedule{});
+            }
+            else{
+                queue_.push(Task([f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable {
+                    f(args...);
+                }), Schedule{});
+            }
         }
         cv_.notify_one();
-        return res;
     }
 };
\ No newline at end of file
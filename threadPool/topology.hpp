@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+// CPUs of the machine grouped by NUMA node
+// On Linux the nodes are read from /sys/devices/system/node and limited to the CPUs
+// this process may run on (sched_getaffinity); otherwise all CPUs form one node
+struct CpuTopology{
+    // CPU ids of every node, nodes without allowed CPUs are dropped
+    std::vector<std::vector<int>> nodes;
+
+    std::size_t cpuCount() const{
+        std::size_t n = 0;
+        for(auto& node : nodes){
+            n += node.size();
+        }
+        return n;
+    }
+
+    static CpuTopology detect(){
+        CpuTopology topo;
+#if defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        auto isAllowed = [&](int cpu){
+            return !haveMask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed));
+        };
+        for(int node = 0; ; node++){
+            std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if(!in){
+                break;
+            }
+            std::string list;
+            std::getline(in, list);
+            std::vector<int> cpus;
+            for(auto cpu : parseCpuList(list)){
+                if(isAllowed(cpu)){
+                    cpus.push_back(cpu);
+                }
+            }
+            if(!cpus.empty()){
+                topo.nodes.push_back(std::move(cpus));
+            }
+        }
+        if(topo.nodes.empty() && haveMask){
+            std::vector<int> cpus;
+            for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+                if(CPU_ISSET(cpu, &allowed)){
+                    cpus.push_back(cpu);
+                }
+            }
+            topo.nodes.push_back(std::move(cpus));
+        }
+#endif
+        if(topo.nodes.empty()){
+            std::vector<int> cpus;
+            for(unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++){
+                cpus.push_back(static_cast<int>(cpu));
+            }
+            topo.nodes.push_back(std::move(cpus));
+        }
+        return topo;
+    }
+
+    // Parse the kernel cpulist format, e.g. "0-3,8-11,16"
+    static std::vector<int> parseCpuList(const std::string& list){
+        std::vector<int> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while(std::getline(ss, range, ',')){
+            if(range.empty()){
+                continue;
+            }
+            auto dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for(int cpu = first; cpu <= last; cpu++){
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+};
+
+// Restrict the calling thread to the given CPUs
+// Returns false if pinning is not supported or failed
+inline bool pinThisThread(const std::vector<int>& cpus){
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(auto cpu : cpus){
+        if(cpu >= 0 && cpu < CPU_SETSIZE){
+            CPU_SET(cpu, &set);
+        }
+    }
+    return !cpus.empty() && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
@@ -0,0 +1,92 @@
+#include "threadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Microbenchmark of ThreadPool_jthread: SingleQueue vs WorkStealing mode
+// Usage: workStealingBench [max workers] [number of tasks]
+
+using Mode = ThreadPool_jthread::Mode;
+
+// Tiny task spawning two children until the given depth is reached
+// Used to submit tasks from inside the pool
+struct Spawn{
+    ThreadPool_jthread* pool;
+    int depth;
+    std::atomic<std::size_t>* done;
+    void operator()() const{
+        if(depth == 0){
+            done->fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pool->post(Spawn{pool, depth - 1, done});
+        pool->post(Spawn{pool, depth - 1, done});
+    }
+};
+
+// Wait until all tasks are executed
+void waitDone(const std::atomic<std::size_t>& done, std::size_t total){
+    while(done.load(std::memory_order_acquire) < total){
+        std::this_thread::yield();
+    }
+}
+
+// All tasks are submitted by the main thread
+double externalTasks(std::size_t workers, Mode mode, std::size_t tasks){
+    std::atomic<std::size_t> done{0};
+    ThreadPool_jthread pool(workers, mode);
+    auto start = std::chrono::high_resolution_clock::now();
+    for(std::size_t i = 0; i < tasks; i++){
+        pool.post([&done]{done.fetch_add(1, std::memory_order_relaxed);});
+    }
+    waitDone(done, tasks);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> sec = end - start;
+    return tasks / sec.count();
+}
+
+// Tasks are spawned recursively by the workers themselves
+double spawnedTasks(std::size_t workers, Mode mode, std::size_t tasks){
+    // Number of leaves is the first power of two not less than tasks
+    int depth = 0;
+    while((std::size_t{1} << depth) < tasks){
+        depth++;
+    }
+    std::size_t leaves = std::size_t{1} << depth;
+    std::atomic<std::size_t> done{0};
+    ThreadPool_jthread pool(workers, mode);
+    auto start = std::chrono::high_resolution_clock::now();
+    pool.post(Spawn{&pool, depth, &done});
+    waitDone(done, leaves);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> sec = end - start;
+    // Count inner tasks too: a binary tree with L leaves has 2L - 1 nodes
+    return (2 * leaves - 1) / sec.count();
+}
+
+int main(int argc, char* argv[]){
+    std::size_t maxWorkers = std::max<std::size_t>(std::thread::hardware_concurrency(), 4);
+    std::size_t tasks = 1000000;
+    if(argc > 1){
+        maxWorkers = std::stoul(argv[1]);
+    }
+    if(argc > 2){
+        tasks = std::stoul(argv[2]);
+    }
+
+    std::cout << "Tasks: " << tasks << ", throughput in tasks/s\n";
+    std::cout << "workers | external single | external stealing | spawned single | spawned stealing\n";
+    for(std::size_t w = 1; w <= maxWorkers; w *= 2){
+        auto extSingle = externalTasks(w, Mode::SingleQueue, tasks);
+        auto extSteal = externalTasks(w, Mode::WorkStealing, tasks);
+        auto spSingle = spawnedTasks(w, Mode::SingleQueue, tasks);
+        auto spSteal = spawnedTasks(w, Mode::WorkStealing, tasks);
+        std::cout << w << " | " << extSingle << " | " << extSteal
+                  << " | " << spSingle << " | " << spSteal << std::endl;
+    }
+}